@@ -0,0 +1,143 @@
+#include "configCache.h"
+#include <cmath>
+#include <algorithm>
+
+CConfigCache::CConfigCache()
+{
+    _cellSize=0.05;
+    _maxEntriesPerGroup=10000;
+}
+
+CConfigCache::~CConfigCache()
+{
+}
+
+void CConfigCache::getSeeds(int env,int group,const std::vector<double>& poses,const std::vector<int>& joints,const double metric[4],double maxDist,size_t maxCnt,std::vector<std::vector<double>>& seeds)
+{ // returns up to maxCnt configurations found for poses within maxDist, nearest first
+    seeds.clear();
+    auto it=_groups.find(env);
+    if (it==_groups.end())
+        return;
+    auto it2=it->second.find(group);
+    if ( (it2==it->second.end())||(poses.size()==0) )
+        return;
+    SConfigCacheGroup& cache=it2->second;
+    SConfigCacheCell cell=_getCell(poses);
+    int r=std::max<int>(1,int(ceil(maxDist/(_cellSize*std::max<double>(1.0e-6,std::min<double>(metric[0],std::min<double>(metric[1],metric[2])))))));
+    r=std::min<int>(r,3);
+    std::vector<std::pair<double,const SConfigCacheEntry*>> candidates;
+    for (int x=-r;x<=r;x++)
+    {
+        for (int y=-r;y<=r;y++)
+        {
+            for (int z=-r;z<=r;z++)
+            {
+                auto it3=cache.cells.find(SConfigCacheCell(std::get<0>(cell)+x,std::get<1>(cell)+y,std::get<2>(cell)+z));
+                if (it3!=cache.cells.end())
+                {
+                    for (size_t i=0;i<it3->second.size();i++)
+                    {
+                        const SConfigCacheEntry& entry=it3->second[i];
+                        if ( (entry.joints==joints)&&(entry.poses.size()==poses.size()) )
+                        {
+                            double d=_getDistance(entry.poses,poses,metric);
+                            if (d<=maxDist)
+                                candidates.push_back(std::make_pair(d,&entry));
+                        }
+                    }
+                }
+            }
+        }
+    }
+    std::sort(candidates.begin(),candidates.end(),[](const std::pair<double,const SConfigCacheEntry*>& a,const std::pair<double,const SConfigCacheEntry*>& b){return(a.first<b.first);});
+    for (size_t i=0;(i<candidates.size())&&(i<maxCnt);i++)
+        seeds.push_back(candidates[i].second->config);
+}
+
+void CConfigCache::add(int env,int group,const std::vector<double>& poses,const std::vector<int>& joints,const std::vector<double>& config)
+{
+    if (poses.size()==0)
+        return;
+    SConfigCacheGroup& cache=_groups[env][group];
+    if (cache.insertionOrder.size()>=_maxEntriesPerGroup)
+    { // drop the oldest entry
+        auto it=cache.cells.find(cache.insertionOrder.front());
+        if (it!=cache.cells.end())
+        {
+            it->second.erase(it->second.begin());
+            if (it->second.size()==0)
+                cache.cells.erase(it);
+        }
+        cache.insertionOrder.pop_front();
+    }
+    SConfigCacheCell cell=_getCell(poses);
+    SConfigCacheEntry entry;
+    entry.poses=poses;
+    entry.joints=joints;
+    entry.config=config;
+    cache.cells[cell].push_back(entry);
+    cache.insertionOrder.push_back(cell);
+}
+
+void CConfigCache::countLookup(int env,int group,bool hit)
+{
+    SConfigCacheGroup& cache=_groups[env][group];
+    if (hit)
+        cache.hits++;
+    else
+        cache.misses++;
+}
+
+bool CConfigCache::getStats(int env,int group,size_t& hits,size_t& misses,size_t& entries)
+{
+    hits=0;
+    misses=0;
+    entries=0;
+    auto it=_groups.find(env);
+    if (it!=_groups.end())
+    {
+        auto it2=it->second.find(group);
+        if (it2!=it->second.end())
+        {
+            hits=it2->second.hits;
+            misses=it2->second.misses;
+            entries=it2->second.insertionOrder.size();
+            return(true);
+        }
+    }
+    return(false);
+}
+
+void CConfigCache::clear(int env,int group)
+{
+    auto it=_groups.find(env);
+    if (it!=_groups.end())
+        it->second.erase(group);
+}
+
+void CConfigCache::removeEnv(int env)
+{
+    _groups.erase(env);
+}
+
+SConfigCacheCell CConfigCache::_getCell(const std::vector<double>& poses) const
+{
+    return(SConfigCacheCell(int(floor(poses[0]/_cellSize)),int(floor(poses[1]/_cellSize)),int(floor(poses[2]/_cellSize))));
+}
+
+double CConfigCache::_getDistance(const std::vector<double>& poses1,const std::vector<double>& poses2,const double metric[4])
+{ // largest metric distance over all target poses
+    double retVal=0.0;
+    for (size_t i=0;i+7<=poses1.size();i+=7)
+    {
+        const double* p1=&poses1[i];
+        const double* p2=&poses2[i];
+        double dx=(p1[0]-p2[0])*metric[0];
+        double dy=(p1[1]-p2[1])*metric[1];
+        double dz=(p1[2]-p2[2])*metric[2];
+        double dot=fabs(p1[3]*p2[3]+p1[4]*p2[4]+p1[5]*p2[5]+p1[6]*p2[6]);
+        double angle=2.0*acos(std::min<double>(1.0,dot))*metric[3];
+        retVal=std::max<double>(retVal,sqrt(dx*dx+dy*dy+dz*dz+angle*angle));
+    }
+    return(retVal);
+}
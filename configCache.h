@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include <map>
+#include <deque>
+#include <tuple>
+#include <cstddef>
+
+struct SConfigCacheEntry
+{
+    std::vector<double> poses; // target poses the configuration was found for (x y z qw qx qy qz each)
+    std::vector<int> joints;
+    std::vector<double> config;
+};
+
+typedef std::tuple<int,int,int> SConfigCacheCell;
+
+struct SConfigCacheGroup
+{
+    std::map<SConfigCacheCell,std::vector<SConfigCacheEntry>> cells; // hashed grid over the first target position
+    std::deque<SConfigCacheCell> insertionOrder;
+    size_t hits;
+    size_t misses;
+};
+
+class CConfigCache
+{ // solved configurations per IK group, indexed by target poses, to warm-start the configuration search. Access only with the interface locked
+public:
+    CConfigCache();
+    virtual ~CConfigCache();
+
+    void getSeeds(int env,int group,const std::vector<double>& poses,const std::vector<int>& joints,const double metric[4],double maxDist,size_t maxCnt,std::vector<std::vector<double>>& seeds);
+    void add(int env,int group,const std::vector<double>& poses,const std::vector<int>& joints,const std::vector<double>& config);
+    void countLookup(int env,int group,bool hit);
+    bool getStats(int env,int group,size_t& hits,size_t& misses,size_t& entries);
+    void clear(int env,int group);
+    void removeEnv(int env);
+
+private:
+    SConfigCacheCell _getCell(const std::vector<double>& poses) const;
+    static double _getDistance(const std::vector<double>& poses1,const std::vector<double>& poses2,const double metric[4]);
+
+    std::map<int,std::map<int,SConfigCacheGroup>> _groups; // env --> (group --> cache)
+    double _cellSize;
+    size_t _maxEntriesPerGroup;
+};
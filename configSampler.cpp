@@ -0,0 +1,165 @@
+#include "configSampler.h"
+#include <algorithm>
+
+static const size_t _sobolMaxDim=16;
+static const size_t _strataCnt=64;
+static const unsigned int _primes[]={2,3,5,7,11,13,17,19,23,29,31,37,41,43,47,53};
+
+struct SSobolInit
+{ // primitive polynomial degree, coefficients, initial direction numbers (Joe & Kuo)
+    unsigned int s;
+    unsigned int a;
+    unsigned int m[6];
+};
+
+static const SSobolInit _sobolInit[_sobolMaxDim-1]={
+    {1,0,{1}},
+    {2,1,{1,3}},
+    {3,1,{1,3,1}},
+    {3,2,{1,1,1}},
+    {4,1,{1,1,3,3}},
+    {4,4,{1,3,5,13}},
+    {5,2,{1,1,5,5,17}},
+    {5,4,{1,1,5,5,5}},
+    {5,7,{1,1,7,11,19}},
+    {5,11,{1,1,5,1,1}},
+    {5,13,{1,1,1,3,11}},
+    {5,14,{1,3,5,5,31}},
+    {6,1,{1,3,3,9,7,49}},
+    {6,13,{1,1,1,15,21,21}},
+    {6,16,{1,3,1,13,27,49}},
+};
+
+CConfigSampler::CConfigSampler(int strategy,unsigned int seed,const std::vector<double>& lows,const std::vector<double>& ranges)
+{
+    _strategy=strategy;
+    _lows.assign(lows.begin(),lows.end());
+    _ranges.assign(ranges.begin(),ranges.end());
+    _rng.seed(seed);
+    _sampleCount=0;
+    size_t dim=_lows.size();
+    if (_strategy==sampling_sobol)
+    {
+        _initSobol();
+        for (size_t i=0;i<dim;i++)
+            _digitalShift.push_back((unsigned int)_rng());
+    }
+    if (_strategy==sampling_halton)
+    {
+        for (size_t i=0;i<dim;i++)
+            _rotation.push_back(_getRandom());
+    }
+}
+
+CConfigSampler::~CConfigSampler()
+{
+}
+
+void CConfigSampler::getNext(double* configs,size_t cnt)
+{ // the next cnt samples, one after the other
+    size_t dim=_lows.size();
+    for (size_t j=0;j<cnt;j++)
+    {
+        double* config=configs+j*dim;
+        _getNextUnitSample(config);
+        for (size_t i=0;i<dim;i++)
+            config[i]=_lows[i]+config[i]*_ranges[i];
+        _sampleCount++;
+    }
+}
+
+void CConfigSampler::_getNextUnitSample(double* unitSample)
+{ // fills unitSample with values in [0,1). Dimensions not covered by a sequence fall back to random values
+    size_t dim=_lows.size();
+    size_t index=_sampleCount;
+    for (size_t i=0;i<dim;i++)
+    {
+        double v;
+        if ( (_strategy==sampling_sobol)&&(i<_sobolMaxDim) )
+        { // Gray code construction, with a random digital shift
+            if (index==0)
+                _sobolState[i]=0;
+            else
+            {
+                size_t c=0;
+                size_t n=index-1;
+                while (n&1)
+                {
+                    n>>=1;
+                    c++;
+                }
+                _sobolState[i]^=_sobolDirections[32*i+std::min<size_t>(c,31)];
+            }
+            v=double(_sobolState[i]^_digitalShift[i])/4294967296.0;
+        }
+        else if ( (_strategy==sampling_halton)&&(i<_sobolMaxDim) )
+        { // radical inverse, with a Cranley-Patterson rotation
+            unsigned int base=_primes[i];
+            double f=1.0;
+            v=0.0;
+            size_t n=index+1;
+            while (n>0)
+            {
+                f/=double(base);
+                v+=f*double(n%base);
+                n/=base;
+            }
+            v+=_rotation[i];
+            if (v>=1.0)
+                v-=1.0;
+        }
+        else if (_strategy==sampling_stratified)
+        { // Latin hypercube, in batches of _strataCnt samples
+            size_t k=index%_strataCnt;
+            if (k==0)
+            {
+                if (i==0)
+                    _strata.resize(dim*_strataCnt);
+                for (size_t j=0;j<_strataCnt;j++)
+                    _strata[i*_strataCnt+j]=j;
+                for (size_t j=_strataCnt-1;j>0;j--)
+                    std::swap(_strata[i*_strataCnt+j],_strata[i*_strataCnt+size_t(_rng()%(j+1))]);
+            }
+            v=(double(_strata[i*_strataCnt+k])+_getRandom())/double(_strataCnt);
+        }
+        else
+            v=_getRandom();
+        unitSample[i]=v;
+    }
+}
+
+void CConfigSampler::_initSobol()
+{
+    size_t dim=std::min<size_t>(_lows.size(),_sobolMaxDim);
+    _sobolDirections.assign(32*dim,0);
+    _sobolState.assign(dim,0);
+    for (size_t k=0;k<32;k++)
+    {
+        if (dim>0)
+            _sobolDirections[k]=1u<<(31-k);
+    }
+    for (size_t i=1;i<dim;i++)
+    {
+        const SSobolInit& init=_sobolInit[i-1];
+        unsigned int* v=&_sobolDirections[32*i];
+        for (size_t k=0;k<32;k++)
+        {
+            if (k<init.s)
+                v[k]=init.m[k]<<(31-k);
+            else
+            {
+                v[k]=v[k-init.s]^(v[k-init.s]>>init.s);
+                for (size_t l=1;l<init.s;l++)
+                {
+                    if ((init.a>>(init.s-1-l))&1)
+                        v[k]^=v[k-l];
+                }
+            }
+        }
+    }
+}
+
+double CConfigSampler::_getRandom()
+{ // in [0,1). Not using std::uniform_real_distribution, which differs across standard libraries
+    return(double(_rng())/4294967296.0);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <random>
+
+enum
+{
+    sampling_random=0,
+    sampling_sobol,
+    sampling_halton,
+    sampling_stratified,
+    sampling_count
+};
+
+class CConfigSampler
+{ // generates joint-space samples for the configuration search. A given seed always yields the same sequence
+public:
+    CConfigSampler(int strategy,unsigned int seed,const std::vector<double>& lows,const std::vector<double>& ranges);
+    virtual ~CConfigSampler();
+
+    void getNext(double* configs,size_t cnt);
+
+private:
+    double _getRandom();
+    void _initSobol();
+    void _getNextUnitSample(double* unitSample);
+
+    int _strategy;
+    std::vector<double> _lows;
+    std::vector<double> _ranges;
+    std::mt19937 _rng;
+    size_t _sampleCount;
+
+    std::vector<unsigned int> _sobolDirections; // 32 per dimension
+    std::vector<unsigned int> _sobolState;
+    std::vector<unsigned int> _digitalShift; // Sobol scrambling, from the seed
+    std::vector<double> _rotation; // Halton Cranley-Patterson rotation, from the seed
+    std::vector<size_t> _strata; // stratified: current batch of shuffled strata, per dimension
+};
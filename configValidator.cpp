@@ -0,0 +1,179 @@
+#include "configValidator.h"
+#include <ik.h>
+#include <simLib/simLib.h>
+#include <simMath/4X4Matrix.h>
+#include <cmath>
+#include <algorithm>
+
+static const size_t _intCnts[validator_count]={0,2,2};
+static const size_t _doubleCnts[validator_count]={1,1,4};
+
+CConfigValidator::CConfigValidator()
+{
+    _sceneModified=false;
+    _collidingPair=-1;
+}
+
+CConfigValidator::~CConfigValidator()
+{
+    restoreScene();
+}
+
+bool CConfigValidator::setup(const std::vector<int>& types,const std::vector<int>& ints,const std::vector<double>& doubles,const std::vector<int>& joints,std::string& err)
+{ // call with the IK environment selected. ints and doubles hold the parameters of all validators, one after the other
+    _validators.clear();
+    _joints.assign(joints.begin(),joints.end());
+    _savedConfig.resize(_joints.size());
+    size_t intOff=0;
+    size_t doubleOff=0;
+    for (size_t i=0;i<types.size();i++)
+    {
+        SConfigValidator validator;
+        validator.type=types[i];
+        if ( (validator.type<0)||(validator.type>=validator_count) )
+        {
+            err="invalid validator type";
+            return(false);
+        }
+        size_t intCnt=_intCnts[validator.type];
+        size_t doubleCnt=_doubleCnts[validator.type];
+        if ( (intOff+intCnt>ints.size())||(doubleOff+doubleCnt>doubles.size()) )
+        {
+            err="invalid validator parameters";
+            return(false);
+        }
+        validator.ints.assign(ints.begin()+intOff,ints.begin()+intOff+intCnt);
+        validator.doubles.assign(doubles.begin()+doubleOff,doubles.begin()+doubleOff+doubleCnt);
+        intOff+=intCnt;
+        doubleOff+=doubleCnt;
+        if ( (validator.type==validator_mindistance)||(validator.type==validator_orientationcone) )
+        { // the checks would otherwise reject every configuration
+            C7Vector tr;
+            if (!ikGetObjectTransformation(validator.ints[0],validator.ints[1],&tr))
+            {
+                err="invalid validator object handles";
+                return(false);
+            }
+        }
+        if ( (validator.type==validator_orientationcone)&&(C3Vector(&validator.doubles[0]).getLength()==0.0) )
+        {
+            err="invalid validator cone axis";
+            return(false);
+        }
+        _validators.push_back(validator);
+    }
+    return(true);
+}
+
+bool CConfigValidator::setCollisionCheck(const std::vector<int>& simJoints,const std::vector<int>& collisionPairs,std::string& err)
+{ // simJoints are the scene joints corresponding to the IK joints, collisionPairs holds pairs of collidable scene entities
+    if ( (collisionPairs.size()%2!=0)||( (collisionPairs.size()>0)&&(simJoints.size()!=_joints.size()) ) )
+    {
+        err="invalid collision pairs or scene joints";
+        return(false);
+    }
+    _simJoints.assign(simJoints.begin(),simJoints.end());
+    _collisionPairs.assign(collisionPairs.begin(),collisionPairs.end());
+    return(true);
+}
+
+bool CConfigValidator::hasValidators() const
+{
+    return( (_validators.size()>0)||(_collisionPairs.size()>0) );
+}
+
+int CConfigValidator::getCollidingPair() const
+{ // index of the pair that collided during the last failed check, or -1
+    return(_collidingPair);
+}
+
+void CConfigValidator::restoreScene()
+{
+    if (_sceneModified)
+    {
+        for (size_t i=0;i<_simJoints.size();i++)
+            simSetJointPosition(_simJoints[i],_savedSimConfig[i]);
+        _sceneModified=false;
+    }
+}
+
+bool CConfigValidator::_checkCollisions(const double* config)
+{
+    if (!_sceneModified)
+    {
+        _savedSimConfig.resize(_simJoints.size());
+        for (size_t i=0;i<_simJoints.size();i++)
+            simGetJointPosition(_simJoints[i],&_savedSimConfig[i]);
+        _sceneModified=true;
+    }
+    for (size_t i=0;i<_simJoints.size();i++)
+        simSetJointPosition(_simJoints[i],config[i]);
+    for (size_t i=0;i<_collisionPairs.size()/2;i++)
+    {
+        if (simCheckCollision(_collisionPairs[2*i+0],_collisionPairs[2*i+1])!=0)
+        {
+            _collidingPair=int(i);
+            return(false);
+        }
+    }
+    return(true);
+}
+
+bool CConfigValidator::isValid(const double* config)
+{ // applies the configuration to the IK joints, checks it, then restores the previous joint positions
+    bool retVal=true;
+    _collidingPair=-1;
+    if (_validators.size()>0)
+    {
+        for (size_t i=0;i<_joints.size();i++)
+        {
+            ikGetJointPosition(_joints[i],&_savedConfig[i]);
+            ikSetJointPosition(_joints[i],config[i]);
+        }
+        for (size_t i=0;retVal&&(i<_validators.size());i++)
+            retVal=_check(_validators[i],config);
+        for (size_t i=0;i<_joints.size();i++)
+            ikSetJointPosition(_joints[i],_savedConfig[i]);
+    }
+    if ( retVal&&(_collisionPairs.size()>0) )
+        retVal=_checkCollisions(config);
+    return(retVal);
+}
+
+bool CConfigValidator::_check(const SConfigValidator& validator,const double* config) const
+{
+    if (validator.type==validator_jointlimitmargin)
+    {
+        double margin=validator.doubles[0];
+        for (size_t i=0;i<_joints.size();i++)
+        {
+            bool cyclic;
+            double interv[2];
+            if ( ikGetJointInterval(_joints[i],&cyclic,interv)&&(!cyclic) )
+            {
+                if ( (config[i]<interv[0]+margin)||(config[i]>interv[0]+interv[1]-margin) )
+                    return(false);
+            }
+        }
+        return(true);
+    }
+    if (validator.type==validator_mindistance)
+    {
+        C7Vector tr;
+        if (!ikGetObjectTransformation(validator.ints[0],validator.ints[1],&tr))
+            return(false);
+        return(tr.X.getLength()>=validator.doubles[0]);
+    }
+    if (validator.type==validator_orientationcone)
+    {
+        C7Vector tr;
+        if (!ikGetObjectTransformation(validator.ints[0],validator.ints[1],&tr))
+            return(false);
+        C3Vector coneAxis(&validator.doubles[0]);
+        double l=coneAxis.getLength();
+        C3Vector tipAxis(tr.Q*C3Vector(0.0,0.0,1.0));
+        double c=std::min<double>(1.0,std::max<double>(-1.0,(tipAxis*coneAxis)/l));
+        return(acos(c)<=validator.doubles[3]);
+    }
+    return(false);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+enum
+{
+    validator_jointlimitmargin=0, // doubles: margin
+    validator_mindistance, // ints: object1, object2. doubles: distance
+    validator_orientationcone, // ints: tip, relativeTo. doubles: cone axis (3 values), max. angle
+    validator_count
+};
+
+struct SConfigValidator
+{
+    int type;
+    std::vector<int> ints;
+    std::vector<double> doubles;
+};
+
+class CConfigValidator
+{ // native configuration checks, evaluated in the current IK environment without script calls.
+  // Object handles are checked by setup. Collision checks apply the configuration to the corresponding scene joints, which are restored only once, by restoreScene or at destruction
+public:
+    CConfigValidator();
+    virtual ~CConfigValidator();
+
+    bool setup(const std::vector<int>& types,const std::vector<int>& ints,const std::vector<double>& doubles,const std::vector<int>& joints,std::string& err);
+    bool setCollisionCheck(const std::vector<int>& simJoints,const std::vector<int>& collisionPairs,std::string& err);
+    bool hasValidators() const;
+    bool isValid(const double* config);
+    int getCollidingPair() const;
+    void restoreScene();
+
+private:
+    bool _check(const SConfigValidator& validator,const double* config) const;
+    bool _checkCollisions(const double* config);
+
+    std::vector<SConfigValidator> _validators;
+    std::vector<int> _joints;
+    std::vector<double> _savedConfig;
+    std::vector<int> _simJoints;
+    std::vector<int> _collisionPairs;
+    std::vector<double> _savedSimConfig;
+    bool _sceneModified;
+    int _collidingPair;
+};
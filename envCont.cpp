@@ -1,5 +1,5 @@
 #include "envCont.h"
-#include <stddef.h>
+#include <algorithm>
 
 CEnvCont::CEnvCont()
 {
@@ -11,32 +11,40 @@ CEnvCont::~CEnvCont()
 
 void CEnvCont::add(int env,int script)
 {
-    _allObjects.push_back(env);
-    _allObjects.push_back(script);
+    _envToScript[env]=script;
+    _scriptToEnvs[script].insert(env);
 }
 
 void CEnvCont::removeFromEnvHandle(int h)
 {
-    for (size_t i=0;i<_allObjects.size()/2;i++)
+    auto it=_envToScript.find(h);
+    if (it!=_envToScript.end())
+        _remove(h,it->second);
+}
+
+std::vector<int> CEnvCont::removeAllFromScriptHandle(int h)
+{ // returns the removed environments, in ascending order
+    std::vector<int> retVal;
+    auto it=_scriptToEnvs.find(h);
+    if (it!=_scriptToEnvs.end())
     {
-        if (_allObjects[2*i+0]==h)
-        {
-            _allObjects.erase(_allObjects.begin()+2*i,_allObjects.begin()+2*i+2);
-            return;
-        }
+        retVal.assign(it->second.begin(),it->second.end());
+        _scriptToEnvs.erase(it);
+        for (size_t i=0;i<retVal.size();i++)
+            _envToScript.erase(retVal[i]);
+        std::sort(retVal.begin(),retVal.end());
     }
+    return(retVal);
 }
 
-int CEnvCont::removeOneFromScriptHandle(int h)
+void CEnvCont::_remove(int env,int script)
 {
-    for (size_t i=0;i<_allObjects.size()/2;i++)
+    _envToScript.erase(env);
+    auto it=_scriptToEnvs.find(script);
+    if (it!=_scriptToEnvs.end())
     {
-        if (_allObjects[2*i+1]==h)
-        {
-            int retVal=_allObjects[2*i+0];
-            _allObjects.erase(_allObjects.begin()+2*i,_allObjects.begin()+2*i+2);
-            return(retVal);
-        }
+        it->second.erase(env);
+        if (it->second.size()==0)
+            _scriptToEnvs.erase(it);
     }
-    return(-1);
 }
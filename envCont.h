@@ -1,6 +1,8 @@
 #pragma once
 
 #include <vector>
+#include <unordered_map>
+#include <unordered_set>
 
 class CEnvCont
 {
@@ -10,8 +12,11 @@ public:
 
     void add(int env,int script);
     void removeFromEnvHandle(int h);
-    int removeOneFromScriptHandle(int h);
+    std::vector<int> removeAllFromScriptHandle(int h);
 
 private:
-    std::vector<int> _allObjects; // env-script pairs
+    void _remove(int env,int script);
+
+    std::unordered_map<int,int> _envToScript; // owning script of each environment
+    std::unordered_map<int,std::unordered_set<int>> _scriptToEnvs; // environments owned by each script
 };
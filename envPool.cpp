@@ -0,0 +1,111 @@
+#include "envPool.h"
+
+CEnvPool::CEnvPool()
+{
+    _maxFreeClones=8;
+}
+
+CEnvPool::~CEnvPool()
+{
+}
+
+int CEnvPool::acquire(int env)
+{ // returns a free clone of env, or -1 if a new one has to be created
+    int retVal=-1;
+    auto it=_pools.find(env);
+    if ( (it!=_pools.end())&&(it->second.freeClones.size()>0) )
+    {
+        retVal=it->second.freeClones.back();
+        it->second.freeClones.pop_back();
+        it->second.usedClones.insert(retVal);
+        _freeClones.erase(retVal);
+    }
+    return(retVal);
+}
+
+void CEnvPool::addClone(int env,int clone)
+{ // a newly created clone, currently in use
+    _pools[env].usedClones.insert(clone);
+}
+
+bool CEnvPool::release(int env,int clone)
+{ // returns false if the clone is outdated (or the pool full), and should be erased by the caller
+    auto it=_pools.find(env);
+    if ( (it==_pools.end())||(it->second.usedClones.erase(clone)==0) )
+        return(false);
+    if (it->second.freeClones.size()>=_maxFreeClones)
+        return(false);
+    it->second.freeClones.push_back(clone);
+    _freeClones.insert(clone);
+    return(true);
+}
+
+int CEnvPool::getSource(int clone) const
+{ // source environment of a clone in use, or -1
+    for (auto it=_pools.begin();it!=_pools.end();++it)
+    {
+        if (it->second.usedClones.count(clone)>0)
+            return(it->first);
+    }
+    return(-1);
+}
+
+bool CEnvPool::isFree(int clone) const
+{ // a free clone is owned by the pool: it must not be accessed from outside, e.g. through a handle of an erased
+  // pooled duplicate
+    return(_freeClones.count(clone)>0);
+}
+
+void CEnvPool::detach(int clone)
+{ // the clone in use does not match its source anymore (e.g. topology change), and will be rejected when released
+    for (auto it=_pools.begin();it!=_pools.end();++it)
+        it->second.usedClones.erase(clone);
+}
+
+std::vector<int> CEnvPool::invalidate(int env)
+{ // returns the free clones, to be erased by the caller. Clones in use are rejected when released
+    std::vector<int> retVal;
+    auto it=_pools.find(env);
+    if (it!=_pools.end())
+    {
+        retVal.swap(it->second.freeClones);
+        for (size_t i=0;i<retVal.size();i++)
+            _freeClones.erase(retVal[i]);
+        it->second.usedClones.clear();
+        it->second.objects.clear();
+        it->second.objectsValid=false;
+    }
+    return(retVal);
+}
+
+std::vector<int> CEnvPool::removeEnv(int env)
+{ // the source environment was erased
+    std::vector<int> retVal(invalidate(env));
+    _pools.erase(env);
+    return(retVal);
+}
+
+std::vector<int> CEnvPool::removeAll()
+{
+    std::vector<int> retVal;
+    for (auto it=_pools.begin();it!=_pools.end();++it)
+        retVal.insert(retVal.end(),it->second.freeClones.begin(),it->second.freeClones.end());
+    _pools.clear();
+    _freeClones.clear();
+    return(retVal);
+}
+
+const std::vector<SEnvStateObject>* CEnvPool::getObjects(int env) const
+{
+    auto it=_pools.find(env);
+    if ( (it!=_pools.end())&&it->second.objectsValid )
+        return(&it->second.objects);
+    return(nullptr);
+}
+
+void CEnvPool::setObjects(int env,const std::vector<SEnvStateObject>& objects)
+{
+    SEnvPool& pool=_pools[env];
+    pool.objects.assign(objects.begin(),objects.end());
+    pool.objectsValid=true;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+#include <map>
+#include <set>
+#include <cstddef>
+
+struct SEnvStateObject
+{ // an object whose state (local pose, and joint position or spherical joint quaternion) can be copied between environments
+    int handle;
+    bool isJoint;
+    int jointType;
+};
+
+struct SEnvPool
+{
+    std::vector<int> freeClones;
+    std::set<int> usedClones;
+    std::vector<SEnvStateObject> objects; // shared by the source and all its clones
+    bool objectsValid=false;
+};
+
+class CEnvPool
+{ // pre-cloned environments per source environment, for internal use. A clone has the same topology as its source,
+  // only the state is copied when it is acquired. Any topology change of the source invalidates its clones.
+  // Access only with the interface locked
+public:
+    CEnvPool();
+    virtual ~CEnvPool();
+
+    int acquire(int env);
+    void addClone(int env,int clone);
+    bool release(int env,int clone);
+    int getSource(int clone) const;
+    void detach(int clone);
+    bool isFree(int clone) const;
+    std::vector<int> invalidate(int env);
+    std::vector<int> removeEnv(int env);
+    std::vector<int> removeAll();
+
+    const std::vector<SEnvStateObject>* getObjects(int env) const;
+    void setObjects(int env,const std::vector<SEnvStateObject>& objects);
+
+private:
+    std::map<int,SEnvPool> _pools; // source env --> clones
+    std::set<int> _freeClones; // free clones of all pools
+    size_t _maxFreeClones;
+};
@@ -0,0 +1,105 @@
+#include "jointDependency.h"
+
+CJointDependencyFunction::CJointDependencyFunction()
+{
+    _type=dependency_polynomial;
+}
+
+CJointDependencyFunction::~CJointDependencyFunction()
+{
+}
+
+bool CJointDependencyFunction::setup(int type,const std::vector<double>& params,std::string& err)
+{ // polynomial: coefficients, lowest degree first. Lookup and spline: x1,y1,x2,y2, etc.
+    _type=type;
+    _coeffs.clear();
+    _xs.clear();
+    _ys.clear();
+    _secondDerivs.clear();
+    if (_type==dependency_polynomial)
+    {
+        if (params.size()==0)
+        {
+            err="missing polynomial coefficients";
+            return(false);
+        }
+        _coeffs.assign(params.begin(),params.end());
+        return(true);
+    }
+    if ( (_type!=dependency_lookup)&&(_type!=dependency_spline) )
+    {
+        err="invalid dependency function type";
+        return(false);
+    }
+    if ( (params.size()<4)||(params.size()%2!=0) )
+    {
+        err="expected at least 2 points, as x/y pairs";
+        return(false);
+    }
+    size_t n=params.size()/2;
+    for (size_t i=0;i<n;i++)
+    {
+        if ( (i>0)&&(params[2*i]<=_xs.back()) )
+        {
+            err="point master positions must be strictly increasing";
+            return(false);
+        }
+        _xs.push_back(params[2*i]);
+        _ys.push_back(params[2*i+1]);
+    }
+    if (_type==dependency_spline)
+    { // natural cubic spline, tridiagonal system solved once here
+        _secondDerivs.assign(n,0.0);
+        std::vector<double> u(n,0.0);
+        for (size_t i=1;i<n-1;i++)
+        {
+            double sig=(_xs[i]-_xs[i-1])/(_xs[i+1]-_xs[i-1]);
+            double p=sig*_secondDerivs[i-1]+2.0;
+            _secondDerivs[i]=(sig-1.0)/p;
+            u[i]=(_ys[i+1]-_ys[i])/(_xs[i+1]-_xs[i])-(_ys[i]-_ys[i-1])/(_xs[i]-_xs[i-1]);
+            u[i]=(6.0*u[i]/(_xs[i+1]-_xs[i-1])-sig*u[i-1])/p;
+        }
+        _secondDerivs[n-1]=0.0;
+        for (size_t k=n-1;k>0;k--)
+            _secondDerivs[k-1]=_secondDerivs[k-1]*_secondDerivs[k]+u[k-1];
+    }
+    return(true);
+}
+
+double CJointDependencyFunction::evaluate(double masterPos) const
+{ // lookup and spline are clamped outside of the point range
+    if (_type==dependency_polynomial)
+    { // Horner
+        double retVal=0.0;
+        for (size_t i=_coeffs.size();i>0;i--)
+            retVal=retVal*masterPos+_coeffs[i-1];
+        return(retVal);
+    }
+    if (masterPos<=_xs.front())
+        return(_ys.front());
+    if (masterPos>=_xs.back())
+        return(_ys.back());
+    size_t i=_findSegment(masterPos);
+    double h=_xs[i+1]-_xs[i];
+    double b=(masterPos-_xs[i])/h;
+    double a=1.0-b;
+    double retVal=a*_ys[i]+b*_ys[i+1];
+    if (_type==dependency_spline)
+        retVal+=((a*a*a-a)*_secondDerivs[i]+(b*b*b-b)*_secondDerivs[i+1])*h*h/6.0;
+    return(retVal);
+}
+
+size_t CJointDependencyFunction::_findSegment(double x) const
+{ // bisection, x is strictly inside the point range
+    size_t lo=0;
+    size_t hi=_xs.size()-1;
+    while (hi-lo>1)
+    {
+        size_t mid=(lo+hi)/2;
+        if (_xs[mid]>x)
+            hi=mid;
+        else
+            lo=mid;
+    }
+    return(lo);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+enum
+{
+    dependency_polynomial=0,
+    dependency_lookup,
+    dependency_spline,
+    dependency_count
+};
+
+class CJointDependencyFunction
+{ // native slave joint position as a function of the master joint position, evaluated without script calls
+public:
+    CJointDependencyFunction();
+    virtual ~CJointDependencyFunction();
+
+    bool setup(int type,const std::vector<double>& params,std::string& err);
+    double evaluate(double masterPos) const;
+
+private:
+    size_t _findSegment(double x) const;
+
+    int _type;
+    std::vector<double> _coeffs; // polynomial: c0, c1, c2, etc.
+    std::vector<double> _xs; // lookup and spline: strictly increasing master positions
+    std::vector<double> _ys;
+    std::vector<double> _secondDerivs; // spline: natural cubic spline second derivatives at the knots
+};
@@ -1,5 +1,11 @@
 #include "simExtIK.h"
 #include "envCont.h"
+#include "syncCont.h"
+#include "configSampler.h"
+#include "configCache.h"
+#include "configValidator.h"
+#include "jointDependency.h"
+#include "envPool.h"
 #include <simLib/simLib.h>
 #include <ik.h>
 #include <simMath/4X4Matrix.h>
@@ -8,6 +14,9 @@
 #include <cstdio>
 #include <simLib/scriptFunctionData.h>
 #include <algorithm>
+#include <chrono>
+#include <unordered_map>
+#include <unordered_set>
 
 #ifdef _WIN32
 #ifdef QT_COMPIL
@@ -33,6 +42,9 @@
 static LIBRARY simLib;
 static WMutex _simpleMutex;
 static CEnvCont* _allEnvironments;
+static CSyncCont* _allSyncGroups;
+static CConfigCache* _configCache;
+static CEnvPool* _envPool;
 
 void lockInterface()
 {
@@ -71,6 +83,173 @@ public:
     };
 };
 
+static int _currentEnvId=-1; // environment currently selected in the kinematics routines. Protected by the interface lock
+
+static bool _selectEnvironment(int envId,bool allowAlsoProtectedEnvironment=false)
+{ // call only with the interface locked. Switches only if the environment is not already the current one
+    if ( (envId==_currentEnvId)&&(!allowAlsoProtectedEnvironment) )
+        return(true);
+    bool retVal=ikSwitchEnvironment(envId,allowAlsoProtectedEnvironment);
+    _currentEnvId=-1;
+    if ( retVal&&(!allowAlsoProtectedEnvironment) )
+        _currentEnvId=envId;
+    return(retVal);
+}
+
+static void _invalidateCurrentEnvironment()
+{ // call after creating, duplicating or erasing an environment
+    _currentEnvId=-1;
+}
+
+static thread_local std::string _contextError; // set when an environment context is refused by the plugin itself
+
+static std::string _getLastError()
+{ // error of the last failed environment context, or of the last failed call to the kinematics routines
+    if (_contextError.size()==0)
+        return(ikGetLastError());
+    std::string retVal;
+    retVal.swap(_contextError);
+    return(retVal);
+}
+
+struct SScriptFunction
+{ // a script callback. With a reference, the callback was registered on the script side, and is reached through
+  // the __simIKcb dispatcher with the reference as first argument (see createStack)
+    int scriptHandleOrType=-1;
+    std::string funcName; // "func" with a script handle, or "func@scriptName" with a script type (legacy)
+    int ref=-1;
+    bool scriptDestroyed=false;
+
+    void set(int scriptHandleOrType_,const std::string& funcName_)
+    {
+        scriptHandleOrType=scriptHandleOrType_;
+        funcName=funcName_;
+        ref=-1;
+        scriptDestroyed=false;
+    };
+    void set(int scriptHandle,int ref_)
+    {
+        scriptHandleOrType=scriptHandle;
+        funcName="__simIKcb";
+        ref=ref_;
+        scriptDestroyed=false;
+    };
+    bool isSet() const
+    {
+        return(funcName.size()>0);
+    };
+    bool belongsTo(int scriptHandle) const
+    {
+        return( isSet()&&(funcName.find('@')==std::string::npos)&&(scriptHandleOrType==scriptHandle) );
+    };
+    int createStack() const
+    { // the arguments of the callback are pushed after the reference, if any
+        int stack=simCreateStack();
+        if (ref!=-1)
+            simPushInt32OntoStack(stack,ref);
+        return(stack);
+    };
+    bool call(int stack) const
+    {
+        if (scriptDestroyed)
+            return(false);
+        return(simCallScriptFunctionEx(scriptHandleOrType,funcName.c_str(),stack)!=-1);
+    };
+};
+
+struct SJacobianCallbackData
+{
+    SScriptFunction func;
+    int sentGroupHandle=-1;
+    std::vector<int> sentRowsAndCols; // row and column metadata last sent to the script
+};
+
+struct SValidationCallbackData
+{
+    SScriptFunction func;
+    size_t jointCnt;
+    CConfigValidator* nativeValidator=nullptr; // checked before the script callback, if any
+};
+
+class CEnvContext
+{ // explicit environment context, valid for the duration of one API call: holds the interface lock, selects the
+  // environment and carries the state needed by callbacks into scripts. The interface lock is released during
+  // script callbacks, and the environment selected again afterwards
+public:
+    CEnvContext(int envId)
+    {
+        _envId=envId;
+        _contextError.clear();
+        lockInterface();
+        if (_envPool->isFree(envId))
+        {
+            _valid=false;
+            _contextError="invalid environment handle";
+        }
+        else
+            _valid=_selectEnvironment(envId);
+        _activeEnvId=envId;
+        _previous=_current;
+        _current=this;
+    };
+    virtual ~CEnvContext()
+    {
+        _current=_previous;
+        unlockInterface();
+    };
+
+    bool isValid() const
+    {
+        return(_valid);
+    };
+    int getEnvId() const
+    {
+        return(_envId);
+    };
+
+    void beginScriptCallback()
+    {
+        unlockInterface();
+    };
+    void endScriptCallback()
+    { // the script might have used other environments in the mean time
+        lockInterface();
+        _selectEnvironment(_activeEnvId);
+    };
+    bool selectWorkEnvironment(int envId)
+    { // e.g. a private copy of the environment, that callbacks should return to
+        _activeEnvId=envId;
+        return(_selectEnvironment(envId));
+    };
+
+    static CEnvContext* current()
+    {
+        return(_current);
+    };
+    static void invalidateScript(int scriptHandle)
+    { // a script was destroyed, possibly during one of its own callbacks: do not call into it anymore
+        for (CEnvContext* ctx=_current;ctx!=nullptr;ctx=ctx->_previous)
+        {
+            if (ctx->jacobianCallback.func.belongsTo(scriptHandle))
+                ctx->jacobianCallback.func.scriptDestroyed=true;
+            if (ctx->validationCallback.func.belongsTo(scriptHandle))
+                ctx->validationCallback.func.scriptDestroyed=true;
+        }
+    };
+
+    SJacobianCallbackData jacobianCallback;
+    SValidationCallbackData validationCallback;
+
+private:
+    int _envId;
+    int _activeEnvId;
+    bool _valid;
+    CEnvContext* _previous;
+    static thread_local CEnvContext* _current;
+};
+
+thread_local CEnvContext* CEnvContext::_current=nullptr;
+
 bool _logCallback(int verbosity,const char* funcName,const char* msg)
 {
     bool retVal=true;
@@ -101,25 +280,224 @@ struct SJointDependCB
 {
     int ikEnv;
     int ikSlave;
-    std::string cbString;
-    int scriptHandle;
+    SScriptFunction func;
+    bool native; // nativeFunc is used instead of the script function
+    CJointDependencyFunction nativeFunc;
 };
 
-static std::vector<SJointDependCB> jointDependInfo;
+static std::unordered_map<unsigned long long,SJointDependCB> jointDependInfo; // keyed by environment and slave joint
+
+static unsigned long long _getJointDependKey(int envId,int slaveJoint)
+{
+    return( (static_cast<unsigned long long>(static_cast<unsigned int>(envId))<<32)|static_cast<unsigned int>(slaveJoint) );
+}
 
 void _removeJointDependencyCallback(int envId,int slaveJoint)
 {
-    for (int i=0;i<int(jointDependInfo.size());i++)
+    if (slaveJoint!=-1)
+        jointDependInfo.erase(_getJointDependKey(envId,slaveJoint));
+    else
+    {
+        for (auto it=jointDependInfo.begin();it!=jointDependInfo.end();)
+        {
+            if (it->second.ikEnv==envId)
+                it=jointDependInfo.erase(it);
+            else
+                ++it;
+        }
+    }
+}
+
+void _copyJointDependencyCallbacks(int envId,int newEnvId)
+{ // a duplicated environment keeps the callback pointers and callback references of its joint dependencies
+    std::vector<SJointDependCB> copies;
+    for (const auto& it:jointDependInfo)
+    {
+        if (it.second.ikEnv==envId)
+        {
+            copies.push_back(it.second);
+            copies.back().ikEnv=newEnvId;
+        }
+    }
+    for (const auto& c:copies)
+        jointDependInfo[_getJointDependKey(newEnvId,c.ikSlave)]=c;
+}
+
+static bool _getEnvStateObjects(std::vector<SEnvStateObject>& objects)
+{ // objects of the current environment
+    objects.clear();
+    int objectHandle;
+    std::string objectName;
+    bool isJoint;
+    int jointType;
+    for (size_t i=0;ikGetObjects(i,&objectHandle,&objectName,&isJoint,&jointType);i++)
+        objects.push_back({objectHandle,isJoint,jointType});
+    return(true);
+}
+
+static bool _getEnvState(const std::vector<SEnvStateObject>& objects,std::vector<double>& state)
+{ // of the current environment: per object, the local pose (x y z qw qx qy qz), then the joint position, or the
+  // spherical joint quaternion (qw qx qy qz)
+    state.clear();
+    for (size_t i=0;i<objects.size();i++)
+    {
+        C7Vector tr;
+        if (!ikGetObjectTransformation(objects[i].handle,ik_handle_parent,&tr))
+            return(false);
+        state.insert(state.end(),{tr.X(0),tr.X(1),tr.X(2),tr.Q(0),tr.Q(1),tr.Q(2),tr.Q(3)});
+        if (objects[i].isJoint)
+        {
+            if (objects[i].jointType==ik_jointtype_spherical)
+            {
+                if (!ikGetJointTransformation(objects[i].handle,&tr))
+                    return(false);
+                state.insert(state.end(),{tr.Q(0),tr.Q(1),tr.Q(2),tr.Q(3)});
+            }
+            else
+            {
+                double pos;
+                if (!ikGetJointPosition(objects[i].handle,&pos))
+                    return(false);
+                state.push_back(pos);
+            }
+        }
+    }
+    return(true);
+}
+
+static bool _isEnvStateCompatible(const std::vector<SEnvStateObject>& objects)
+{ // checks that the current environment has the objects of a state, with the same types, before anything is written
+    for (size_t i=0;i<objects.size();i++)
     {
-        if (jointDependInfo[i].ikEnv==envId)
+        int objectType;
+        if ( (!ikGetObjectType(objects[i].handle,&objectType))||((objectType==ik_objecttype_joint)!=objects[i].isJoint) )
+            return(false);
+        if (objects[i].isJoint)
         {
-            if ( (jointDependInfo[i].ikSlave==slaveJoint)||(slaveJoint==-1) )
+            int jointType;
+            if ( (!ikGetJointType(objects[i].handle,&jointType))||(jointType!=objects[i].jointType) )
+                return(false);
+        }
+    }
+    return(true);
+}
+
+static bool _setEnvState(const std::vector<SEnvStateObject>& objects,const std::vector<double>& state)
+{ // of the current environment, see _getEnvState
+    size_t off=0;
+    for (size_t i=0;i<objects.size();i++)
+    {
+        if (off+7>state.size())
+            return(false);
+        const double* v=&state[off];
+        C7Vector tr(C4Vector(v[3],v[4],v[5],v[6]),C3Vector(v));
+        if (!ikSetObjectTransformation(objects[i].handle,ik_handle_parent,&tr))
+            return(false);
+        off+=7;
+        if (objects[i].isJoint)
+        {
+            if (objects[i].jointType==ik_jointtype_spherical)
+            {
+                if (off+4>state.size())
+                    return(false);
+                C4Vector q(state[off+0],state[off+1],state[off+2],state[off+3]);
+                if (!ikSetSphericalJointQuaternion(objects[i].handle,&q))
+                    return(false);
+                off+=4;
+            }
+            else
             {
-                jointDependInfo.erase(jointDependInfo.begin()+i);
-                i--;
+                if ( (off+1>state.size())||(!ikSetJointPosition(objects[i].handle,state[off])) )
+                    return(false);
+                off+=1;
             }
         }
     }
+    return(off==state.size());
+}
+
+static void _eraseEnvClones(const std::vector<int>& clones)
+{
+    for (size_t i=0;i<clones.size();i++)
+    {
+        if (_selectEnvironment(clones[i]))
+            ikEraseEnvironment();
+        _invalidateCurrentEnvironment();
+        _removeJointDependencyCallback(clones[i],-1);
+    }
+}
+
+static void _invalidateEnvPool(int envId)
+{ // call before a topology change of envId. Reselects envId if needed
+    _allSyncGroups->invalidateTargets(envId); // parenting might change
+    _envPool->detach(envId); // envId might itself be a pooled duplicate
+    std::vector<int> clones(_envPool->invalidate(envId));
+    if (clones.size()>0)
+    {
+        _eraseEnvClones(clones);
+        _selectEnvironment(envId);
+    }
+}
+
+static bool _acquireEnvClone(int envId,int* cloneId)
+{ // call with envId selected. Returns a private copy of envId, selected, taken from the pool when possible. Release it with _releaseEnvClone
+    int clone=_envPool->acquire(envId);
+    if (clone!=-1)
+    { // only copy the state into the pooled clone
+        const std::vector<SEnvStateObject>* objects=_envPool->getObjects(envId);
+        std::vector<double> state;
+        if ( (objects!=nullptr)&&_getEnvState(objects[0],state)&&_selectEnvironment(clone)&&_setEnvState(objects[0],state) )
+        {
+            cloneId[0]=clone;
+            return(true);
+        }
+        // the pool is out of sync with its source: start over
+        std::vector<int> clones(_envPool->invalidate(envId));
+        clones.push_back(clone);
+        _eraseEnvClones(clones);
+        if (!_selectEnvironment(envId))
+            return(false);
+    }
+    if (_envPool->getObjects(envId)==nullptr)
+    {
+        std::vector<SEnvStateObject> objects;
+        _getEnvStateObjects(objects);
+        _envPool->setObjects(envId,objects);
+    }
+    bool duplicated=ikDuplicateEnvironment(&clone);
+    _invalidateCurrentEnvironment();
+    if (!duplicated)
+        return(false);
+    _envPool->addClone(envId,clone);
+    _copyJointDependencyCallbacks(envId,clone);
+    cloneId[0]=clone;
+    return(_selectEnvironment(clone));
+}
+
+static void _releaseEnvClone(int envId,int cloneId)
+{ // outdated clones are erased, the others go back to the pool
+    if (!_envPool->release(envId,cloneId))
+        _eraseEnvClones(std::vector<int>(1,cloneId));
+}
+
+static bool _eraseUserEnvironment(int envId)
+{ // pooled duplicates go back to the pool of their source, other environments are erased
+    int poolSource=_envPool->getSource(envId);
+    bool retVal=( (poolSource!=-1)&&_envPool->release(poolSource,envId) );
+    if (!retVal)
+    {
+        _removeJointDependencyCallback(envId,-1);
+        retVal=( _selectEnvironment(envId)&&ikEraseEnvironment() );
+    }
+    _invalidateCurrentEnvironment();
+    return(retVal);
+}
+
+static bool _eraseObject(int envId,int objectHandle)
+{ // call with envId selected
+    _invalidateEnvPool(envId); // topology change
+    _removeJointDependencyCallback(envId,objectHandle);
+    return(ikEraseObject(objectHandle));
 }
 
 // --------------------------------------------------------------------------------------
@@ -148,10 +526,11 @@ void LUA_CREATEENVIRONMENT_CALLBACK(SScriptCallBack* p)
         {
             CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
             res=ikCreateEnvironment(&retVal,flags);
+            _invalidateCurrentEnvironment();
             if (res)
                 _allEnvironments->add(retVal,p->scriptID);
             else
-                err=ikGetLastError();
+                err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_CREATEENVIRONMENT_COMMAND,err.c_str());
@@ -184,17 +563,22 @@ void LUA_ERASEENVIRONMENT_CALLBACK(SScriptCallBack* p)
         int envId=inData->at(0).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
-                _removeJointDependencyCallback(envId,-1);
-                if (ikEraseEnvironment())
+                bool erased=_eraseUserEnvironment(envId);
+                if (erased)
+                {
                     _allEnvironments->removeFromEnvHandle(envId);
+                    _allSyncGroups->removeEnv(envId);
+                    _configCache->removeEnv(envId);
+                    _eraseEnvClones(_envPool->removeEnv(envId));
+                }
                 else
-                    err=ikGetLastError();
+                    err=_getLastError();
             }
             else
-                err=ikGetLastError();
+                err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_ERASEENVIRONMENT_COMMAND,err.c_str());
@@ -209,8 +593,9 @@ void LUA_ERASEENVIRONMENT_CALLBACK(SScriptCallBack* p)
 #define LUA_DUPLICATEENVIRONMENT_COMMAND "simIK.duplicateEnvironment"
 
 const int inArgs_DUPLICATEENVIRONMENT[]={
-    1,
+    2,
     sim_script_arg_int32,0,
+    sim_script_arg_bool|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // pooled
 };
 
 void LUA_DUPLICATEENVIRONMENT_CALLBACK(SScriptCallBack* p)
@@ -218,25 +603,38 @@ void LUA_DUPLICATEENVIRONMENT_CALLBACK(SScriptCallBack* p)
     CScriptFunctionData D;
     int retVal=-1;
     bool res=false;
-    if (D.readDataFromStack(p->stackID,inArgs_DUPLICATEENVIRONMENT,inArgs_DUPLICATEENVIRONMENT[0],LUA_DUPLICATEENVIRONMENT_COMMAND))
+    if (D.readDataFromStack(p->stackID,inArgs_DUPLICATEENVIRONMENT,inArgs_DUPLICATEENVIRONMENT[0]-1,LUA_DUPLICATEENVIRONMENT_COMMAND))
     {
         std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
         int envId=inData->at(0).int32Data[0];
+        bool pooled=( (inData->size()>1)&&(inData->at(1).boolData.size()==1)&&inData->at(1).boolData[0] );
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
-                if (ikDuplicateEnvironment(&retVal))
+                if (pooled)
+                { // a full clone taken from the pool of envId when possible, with the state of envId copied into it
+                    if (_acquireEnvClone(envId,&retVal))
+                    {
+                        _allEnvironments->add(retVal,p->scriptID);
+                        res=true;
+                    }
+                    else
+                        err=_getLastError();
+                }
+                else if (ikDuplicateEnvironment(&retVal))
                 {
+                    _invalidateCurrentEnvironment();
                     _allEnvironments->add(retVal,p->scriptID);
+                    _copyJointDependencyCallbacks(envId,retVal);
                     res=true;
                 }
                 else
-                    err=ikGetLastError();
+                    err=_getLastError();
             }
             else
-                err=ikGetLastError();
+                err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_DUPLICATEENVIRONMENT_COMMAND,err.c_str());
@@ -271,14 +669,15 @@ void LUA_LOAD_CALLBACK(SScriptCallBack* p)
         std::string buff(inData->at(1).stringData[0]);
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
+                _invalidateEnvPool(envId); // topology change
                 if (!ikLoad((unsigned char*)buff.c_str(),buff.length()))
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_LOAD_COMMAND,err.c_str());
@@ -309,8 +708,8 @@ void LUA_SAVE_CALLBACK(SScriptCallBack* p)
 
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 size_t l;
                 unsigned char* data=ikSave(&l);
@@ -320,10 +719,10 @@ void LUA_SAVE_CALLBACK(SScriptCallBack* p)
                     retVal.assign(data,data+l);
                 }
                 else
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_SAVE_COMMAND,err.c_str());
@@ -359,15 +758,15 @@ void LUA_GETOBJECTHANDLE_CALLBACK(SScriptCallBack* p)
         int envId=inData->at(0).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetObjectHandle(inData->at(1).stringData[0].c_str(),&retVal);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETOBJECTHANDLE_COMMAND,err.c_str());
@@ -403,14 +802,14 @@ void LUA_DOESOBJECTEXIST_CALLBACK(SScriptCallBack* p)
         int envId=inData->at(0).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 retVal=ikDoesObjectExist(inData->at(1).stringData[0].c_str());
                 result=true;
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_DOESOBJECTEXIST_COMMAND,err.c_str());
@@ -445,15 +844,14 @@ void LUA_ERASEOBJECT_CALLBACK(SScriptCallBack* p)
         int objectHandle=inData->at(1).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
-                _removeJointDependencyCallback(envId,objectHandle);
-                if (!ikEraseObject(objectHandle))
-                     err=ikGetLastError();
+                if (!_eraseObject(envId,objectHandle))
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_ERASEOBJECT_COMMAND,err.c_str());
@@ -485,15 +883,15 @@ void LUA_GETOBJECTPARENT_CALLBACK(SScriptCallBack* p)
         int objectHandle=inData->at(1).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetObjectParent(objectHandle,&retVal);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETOBJECTPARENT_COMMAND,err.c_str());
@@ -534,15 +932,16 @@ void LUA_SETOBJECTPARENT_CALLBACK(SScriptCallBack* p)
             keepInPlace=inData->at(3).boolData[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
+                _invalidateEnvPool(envId); // topology change
                 bool result=ikSetObjectParent(objectHandle,parentObjectHandle,keepInPlace);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_SETOBJECTPARENT_COMMAND,err.c_str());
@@ -574,15 +973,15 @@ void LUA_GETOBJECTTYPE_CALLBACK(SScriptCallBack* p)
         int objectHandle=inData->at(1).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetObjectType(objectHandle,&retVal);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETOBJECTTYPE_COMMAND,err.c_str());
@@ -622,15 +1021,15 @@ void LUA_GETOBJECTS_CALLBACK(SScriptCallBack* p)
         int index=inData->at(1).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetObjects(size_t(index),&objectHandle,&objectName,&isJoint,&jointType);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETOBJECTS_COMMAND,err.c_str());
@@ -669,18 +1068,19 @@ void LUA_CREATEDUMMY_CALLBACK(SScriptCallBack* p)
         int envId=inData->at(0).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
+                _invalidateEnvPool(envId); // topology change
                 const char* nm=nullptr;
                 if ( (inData->size()>1)&&(inData->at(1).stringData.size()==1)&&(inData->at(1).stringData[0].size()>0) )
                     nm=inData->at(1).stringData[0].c_str();
                 result=ikCreateDummy(nm,&retVal);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_CREATEDUMMY_COMMAND,err.c_str());
@@ -717,15 +1117,15 @@ void LUA_GETTARGETDUMMY_CALLBACK(SScriptCallBack* p)
         int dummyHandle=inData->at(1).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetTargetDummy(dummyHandle,&retVal);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETTARGETDUMMY_COMMAND,err.c_str());
@@ -762,15 +1162,16 @@ void LUA_SETTARGETDUMMY_CALLBACK(SScriptCallBack* p)
         int targetDummyHandle=inData->at(2).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
+                _invalidateEnvPool(envId); // topology change
                 bool result=ikSetTargetDummy(dummyHandle,targetDummyHandle);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_SETTARGETDUMMY_COMMAND,err.c_str());
@@ -802,15 +1203,15 @@ void LUA_GETLINKEDDUMMY_CALLBACK(SScriptCallBack* p)
         int dummyHandle=inData->at(1).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetLinkedDummy(dummyHandle,&retVal);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETLINKEDDUMMY_COMMAND,err.c_str());
@@ -847,15 +1248,16 @@ void LUA_SETLINKEDDUMMY_CALLBACK(SScriptCallBack* p)
         int linkedDummyHandle=inData->at(2).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
+                _invalidateEnvPool(envId); // topology change
                 bool result=ikSetLinkedDummy(dummyHandle,linkedDummyHandle);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_SETLINKEDDUMMY_COMMAND,err.c_str());
@@ -887,19 +1289,20 @@ void LUA_CREATEJOINT_CALLBACK(SScriptCallBack* p)
         int envId=inData->at(0).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
+                _invalidateEnvPool(envId); // topology change
                 int jType=inData->at(1).int32Data[0];
                 const char* nm=nullptr;
                 if ( (inData->size()>2)&&(inData->at(2).stringData.size()==1)&&(inData->at(2).stringData[0].size()>0) )
                     nm=inData->at(2).stringData[0].c_str();
                 result=ikCreateJoint(nm,jType,&retVal);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_CREATEJOINT_COMMAND,err.c_str());
@@ -936,15 +1339,15 @@ void LUA_GETJOINTTYPE_CALLBACK(SScriptCallBack* p)
         int jointHandle=inData->at(1).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetJointType(jointHandle,&retVal);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETJOINTTYPE_COMMAND,err.c_str());
@@ -981,15 +1384,15 @@ void LUA_GETJOINTMODE_CALLBACK(SScriptCallBack* p)
         int jointHandle=inData->at(1).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetJointMode(jointHandle,&retVal);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETJOINTMODE_COMMAND,err.c_str());
@@ -1026,15 +1429,16 @@ void LUA_SETJOINTMODE_CALLBACK(SScriptCallBack* p)
         int jointMode=inData->at(2).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
+                _invalidateEnvPool(envId); // topology change
                 bool result=ikSetJointMode(jointHandle,jointMode);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_SETJOINTMODE_COMMAND,err.c_str());
@@ -1067,15 +1471,15 @@ void LUA_GETJOINTINTERVAL_CALLBACK(SScriptCallBack* p)
         int jointHandle=inData->at(1).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetJointInterval(jointHandle,&cyclic,interv);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETJOINTINTERVAL_COMMAND,err.c_str());
@@ -1115,19 +1519,20 @@ void LUA_SETJOINTINTERVAL_CALLBACK(SScriptCallBack* p)
         bool cyclic=inData->at(2).boolData[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
+                _invalidateEnvPool(envId); // topology change
                 double* interv=nullptr;
                 if ( (inData->size()>3)&&(inData->at(3).doubleData.size()>=2) )
                     interv=&inData->at(3).doubleData[0];
 
                 bool result=ikSetJointInterval(jointHandle,cyclic,interv);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_SETJOINTINTERVAL_COMMAND,err.c_str());
@@ -1159,15 +1564,15 @@ void LUA_GETJOINTSCREWLEAD_CALLBACK(SScriptCallBack* p)
         int jointHandle=inData->at(1).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetJointScrewLead(jointHandle,&lead);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETJOINTSCREWLEAD_COMMAND,err.c_str());
@@ -1204,15 +1609,16 @@ void LUA_SETJOINTSCREWLEAD_CALLBACK(SScriptCallBack* p)
         double lead=inData->at(2).doubleData[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
+                _invalidateEnvPool(envId); // topology change
                 bool result=ikSetJointScrewLead(jointHandle,lead);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_SETJOINTSCREWLEAD_COMMAND,err.c_str());
@@ -1245,15 +1651,15 @@ void LUA_GETJOINTSCREWPITCH_CALLBACK(SScriptCallBack* p)
         int jointHandle=inData->at(1).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetJointScrewPitch(jointHandle,&pitch);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETJOINTSCREWPITCH_COMMAND,err.c_str());
@@ -1290,15 +1696,16 @@ void LUA_SETJOINTSCREWPITCH_CALLBACK(SScriptCallBack* p)
         double pitch=inData->at(2).doubleData[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
+                _invalidateEnvPool(envId); // topology change
                 bool result=ikSetJointScrewPitch(jointHandle,pitch);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_SETJOINTSCREWPITCH_COMMAND,err.c_str());
@@ -1330,15 +1737,15 @@ void LUA_GETJOINTIKWEIGHT_CALLBACK(SScriptCallBack* p)
         int jointHandle=inData->at(1).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetJointWeight(jointHandle,&weight);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETJOINTIKWEIGHT_COMMAND,err.c_str());
@@ -1375,15 +1782,16 @@ void LUA_SETJOINTIKWEIGHT_CALLBACK(SScriptCallBack* p)
         double weight=inData->at(2).doubleData[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
+                _invalidateEnvPool(envId); // topology change
                 bool result=ikSetJointWeight(jointHandle,weight);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_SETJOINTIKWEIGHT_COMMAND,err.c_str());
@@ -1415,15 +1823,15 @@ void LUA_GETJOINTLIMITMARGIN_CALLBACK(SScriptCallBack* p)
         int jointHandle=inData->at(1).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetJointLimitMargin(jointHandle,&weight);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETJOINTLIMITMARGIN_COMMAND,err.c_str());
@@ -1460,15 +1868,16 @@ void LUA_SETJOINTLIMITMARGIN_CALLBACK(SScriptCallBack* p)
         double weight=inData->at(2).doubleData[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
+                _invalidateEnvPool(envId); // topology change
                 bool result=ikSetJointLimitMargin(jointHandle,weight);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_SETJOINTLIMITMARGIN_COMMAND,err.c_str());
@@ -1500,15 +1909,15 @@ void LUA_GETJOINTMAXSTEPSIZE_CALLBACK(SScriptCallBack* p)
         int jointHandle=inData->at(1).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetJointMaxStepSize(jointHandle,&stepSize);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETJOINTMAXSTEPSIZE_COMMAND,err.c_str());
@@ -1545,15 +1954,16 @@ void LUA_SETJOINTMAXSTEPSIZE_CALLBACK(SScriptCallBack* p)
         double stepSize=inData->at(2).doubleData[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
+                _invalidateEnvPool(envId); // topology change
                 bool result=ikSetJointMaxStepSize(jointHandle,stepSize);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_SETJOINTMAXSTEPSIZE_COMMAND,err.c_str());
@@ -1587,15 +1997,15 @@ void LUA_GETJOINTDEPENDENCY_CALLBACK(SScriptCallBack* p)
         int jointHandle=inData->at(1).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetJointDependency(jointHandle,&depJoint,&offset,&mult);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETJOINTDEPENDENCY_COMMAND,err.c_str());
@@ -1616,22 +2026,16 @@ void LUA_GETJOINTDEPENDENCY_CALLBACK(SScriptCallBack* p)
 double jointDependencyCallback(int ikEnv,int slaveJoint,double masterPos)
 {
     double retVal=0.0;
-    int ind=-1;
-    for (size_t i=0;i<jointDependInfo.size();i++)
-    {
-        if ( (jointDependInfo[i].ikEnv==ikEnv)&&(jointDependInfo[i].ikSlave==slaveJoint) )
-        {
-            ind=i;
-            break;
-        }
-    }
-    if (ind!=-1)
+    auto it=jointDependInfo.find(_getJointDependKey(ikEnv,slaveJoint));
+    if (it!=jointDependInfo.end())
     {
-        int stack=simCreateStack();
-        simPushInt32OntoStack(stack,ikEnv);
+        if (it->second.native)
+            return(it->second.nativeFunc.evaluate(masterPos));
+        int stack=it->second.func.createStack();
         simPushInt32OntoStack(stack,slaveJoint);
         simPushDoubleOntoStack(stack,masterPos);
-        if (simCallScriptFunctionEx(jointDependInfo[ind].scriptHandle,jointDependInfo[ind].cbString.c_str(),stack)!=-1)
+        simPushInt32OntoStack(stack,ikEnv);
+        if (it->second.func.call(stack))
         {
             while (simGetStackSize(stack)>1)
                 simPopStackItem(stack,1);
@@ -1650,20 +2054,22 @@ double jointDependencyCallback(int ikEnv,int slaveJoint,double masterPos)
 #define LUA_SETJOINTDEPENDENCY_COMMAND "simIK._setJointDependency"
 
 const int inArgs_SETJOINTDEPENDENCY[]={
-    7,
+    9,
     sim_script_arg_int32,0,
     sim_script_arg_int32,0,
     sim_script_arg_int32,0,
     sim_script_arg_double,0,
     sim_script_arg_double,0,
-    sim_script_arg_string|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // cb func name
+    sim_script_arg_int32|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // cb reference
     sim_script_arg_int32|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // script handle of cb
+    sim_script_arg_int32|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // native dependency function type
+    sim_script_arg_double|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // native dependency function parameters
 };
 
 void LUA_SETJOINTDEPENDENCY_CALLBACK(SScriptCallBack* p)
 {
     CScriptFunctionData D;
-    if (D.readDataFromStack(p->stackID,inArgs_SETJOINTDEPENDENCY,inArgs_SETJOINTDEPENDENCY[0]-4,LUA_SETJOINTDEPENDENCY_COMMAND))
+    if (D.readDataFromStack(p->stackID,inArgs_SETJOINTDEPENDENCY,inArgs_SETJOINTDEPENDENCY[0]-6,LUA_SETJOINTDEPENDENCY_COMMAND))
     {
         std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
         int envId=inData->at(0).int32Data[0];
@@ -1675,35 +2081,49 @@ void LUA_SETJOINTDEPENDENCY_CALLBACK(SScriptCallBack* p)
             off=inData->at(3).doubleData[0];
         if ( (inData->size()>4)&&(inData->at(4).doubleData.size()==1) )
             mult=inData->at(4).doubleData[0];
-        std::string cbString;
-        if ( (inData->size()>5)&&(inData->at(5).stringData.size()==1) )
-            cbString=inData->at(5).stringData[0];
+        int cbRef=-1;
+        if ( (inData->size()>5)&&(inData->at(5).int32Data.size()==1) )
+            cbRef=inData->at(5).int32Data[0];
         int cbScriptHandle=-1;
         if ( (inData->size()>6)&&(inData->at(6).int32Data.size()==1) )
             cbScriptHandle=inData->at(6).int32Data[0];
+        int nativeType=-1;
+        if ( (inData->size()>7)&&(inData->at(7).int32Data.size()==1) )
+            nativeType=inData->at(7).int32Data[0];
         std::string err;
+        SJointDependCB a;
+        a.ikEnv=envId;
+        a.ikSlave=jointHandle;
+        a.native=(nativeType!=-1);
+        if (a.native)
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            std::vector<double> noParams;
+            const std::vector<double>* params=&noParams;
+            if (inData->size()>8)
+                params=&inData->at(8).doubleData;
+            a.nativeFunc.setup(nativeType,*params,err);
+        }
+        else if ( (cbScriptHandle!=-1)&&(cbRef!=-1) )
+            a.func.set(cbScriptHandle,cbRef);
+        if (err.size()==0)
+        {
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
+                _invalidateEnvPool(envId); // topology change
                 _removeJointDependencyCallback(envId,jointHandle);
                 double(*cb)(int ikEnv,int slaveJoint,double masterPos)=nullptr;
-                if ( (cbScriptHandle!=-1)&&(cbString.size()>0) )
+                if ( a.native||a.func.isSet() )
                 {
-                    SJointDependCB a;
-                    a.ikEnv=envId;
-                    a.ikSlave=jointHandle;
-                    a.cbString=cbString;
-                    a.scriptHandle=cbScriptHandle;
-                    jointDependInfo.push_back(a);
+                    jointDependInfo[_getJointDependKey(envId,jointHandle)]=a;
                     cb=jointDependencyCallback;
                 }
                 bool result=ikSetJointDependency(jointHandle,depJointHandle,off,mult,cb);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_SETJOINTDEPENDENCY_COMMAND,err.c_str());
@@ -1735,15 +2155,15 @@ void LUA_GETJOINTPOSITION_CALLBACK(SScriptCallBack* p)
         int jointHandle=inData->at(1).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetJointPosition(jointHandle,&pos);
                 if (!result)
-                    err=ikGetLastError();
+                    err=_getLastError();
             }
             else
-                err=ikGetLastError();
+                err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETJOINTPOSITION_COMMAND,err.c_str());
@@ -1780,15 +2200,15 @@ void LUA_SETJOINTPOSITION_CALLBACK(SScriptCallBack* p)
         double pos=inData->at(2).doubleData[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 bool result=ikSetJointPosition(jointHandle,pos);
                 if (!result)
-                    err=ikGetLastError();
+                    err=_getLastError();
             }
             else
-                err=ikGetLastError();
+                err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_SETJOINTPOSITION_COMMAND,err.c_str());
@@ -1820,18 +2240,18 @@ void LUA_GETJOINTMATRIX_CALLBACK(SScriptCallBack* p)
         int jointHandle=inData->at(1).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 C7Vector tr;
                 result=ikGetJointTransformation(jointHandle,&tr);
                 if (result)
                     tr.getMatrix().getData(matrix);
                 else
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETJOINTMATRIX_COMMAND,err.c_str());
@@ -1869,18 +2289,18 @@ void LUA_SETSPHERICALJOINTMATRIX_CALLBACK(SScriptCallBack* p)
         double* m=&inData->at(2).doubleData[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 C4X4Matrix _m;
                 _m.setData(m);
                 C4Vector q(_m.M.getQuaternion());
                 bool result=ikSetSphericalJointQuaternion(jointHandle,&q);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_SETSPHERICALJOINTMATRIX_COMMAND,err.c_str());
@@ -1914,8 +2334,8 @@ void LUA_GETJOINTTRANSFORMATION_CALLBACK(SScriptCallBack* p)
         int jointHandle=inData->at(1).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 C7Vector tr;
                 result=ikGetJointTransformation(jointHandle,&tr);
@@ -1930,10 +2350,10 @@ void LUA_GETJOINTTRANSFORMATION_CALLBACK(SScriptCallBack* p)
                     tr.Q.getEulerAngles().getData(e);
                 }
                 else
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETJOINTTRANSFORMATION_COMMAND,err.c_str());
@@ -1980,8 +2400,8 @@ void LUA_SETSPHERICALJOINTROTATION_CALLBACK(SScriptCallBack* p)
             quat=&inData->at(2).doubleData[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {   // CoppeliaSim quaternion, internally: w x y z
                 // CoppeliaSim quaternion, at interfaces: x y z w
                 C4Vector q;
@@ -1991,10 +2411,10 @@ void LUA_SETSPHERICALJOINTROTATION_CALLBACK(SScriptCallBack* p)
                     q=C4Vector(quat[3],quat[0],quat[1],quat[2]);
                 bool result=ikSetSphericalJointQuaternion(jointHandle,&q);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_SETSPHERICALJOINTROTATION_COMMAND,err.c_str());
@@ -2003,144 +2423,353 @@ void LUA_SETSPHERICALJOINTROTATION_CALLBACK(SScriptCallBack* p)
 // --------------------------------------------------------------------------------------
 
 // --------------------------------------------------------------------------------------
-// simIK.getGroupHandle
+// simIK.getJointPositions
 // --------------------------------------------------------------------------------------
-#define LUA_GETIKGROUPHANDLE_COMMAND_PLUGIN "simIK.getGroupHandle@IK"
-#define LUA_GETIKGROUPHANDLE_COMMAND "simIK.getGroupHandle"
+#define LUA_GETJOINTPOSITIONS_COMMAND_PLUGIN "simIK.getJointPositions@IK"
+#define LUA_GETJOINTPOSITIONS_COMMAND "simIK.getJointPositions"
 
-const int inArgs_GETIKGROUPHANDLE[]={
+const int inArgs_GETJOINTPOSITIONS[]={
     2,
     sim_script_arg_int32,0,
-    sim_script_arg_string,0,
+    sim_script_arg_int32|sim_script_arg_table,1,
 };
 
-void LUA_GETIKGROUPHANDLE_CALLBACK(SScriptCallBack* p)
+void LUA_GETJOINTPOSITIONS_CALLBACK(SScriptCallBack* p)
 {
     CScriptFunctionData D;
-    int retVal=-1;
+    std::vector<double> positions;
     bool result=false;
-    if (D.readDataFromStack(p->stackID,inArgs_GETIKGROUPHANDLE,inArgs_GETIKGROUPHANDLE[0],LUA_GETIKGROUPHANDLE_COMMAND))
+    if (D.readDataFromStack(p->stackID,inArgs_GETJOINTPOSITIONS,inArgs_GETJOINTPOSITIONS[0],LUA_GETJOINTPOSITIONS_COMMAND))
     {
         std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
         int envId=inData->at(0).int32Data[0];
+        const std::vector<int>& jointHandles=inData->at(1).int32Data;
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
-                result=ikGetGroupHandle(inData->at(1).stringData[0].c_str(),&retVal);
-                if (!result)
-                     err=ikGetLastError();
+                positions.resize(jointHandles.size());
+                result=true;
+                for (size_t i=0;i<jointHandles.size();i++)
+                {
+                    if (!ikGetJointPosition(jointHandles[i],&positions[i]))
+                    {
+                        err=_getLastError();
+                        result=false;
+                        break;
+                    }
+                }
             }
             else
-                 err=ikGetLastError();
+                err=_getLastError();
         }
         if (err.size()>0)
-            simSetLastError(LUA_GETIKGROUPHANDLE_COMMAND,err.c_str());
+            simSetLastError(LUA_GETJOINTPOSITIONS_COMMAND,err.c_str());
     }
     if (result)
     {
-        D.pushOutData(CScriptFunctionDataItem(retVal));
+        D.pushOutData(CScriptFunctionDataItem(positions));
         D.writeDataToStack(p->stackID);
     }
 }
 // --------------------------------------------------------------------------------------
 
 // --------------------------------------------------------------------------------------
-// simIK.doesGroupExist
+// simIK.setJointPositions
 // --------------------------------------------------------------------------------------
-#define LUA_DOESIKGROUPEXIST_COMMAND_PLUGIN "simIK.doesGroupExist@IK"
-#define LUA_DOESIKGROUPEXIST_COMMAND "simIK.doesGroupExist"
+#define LUA_SETJOINTPOSITIONS_COMMAND_PLUGIN "simIK.setJointPositions@IK"
+#define LUA_SETJOINTPOSITIONS_COMMAND "simIK.setJointPositions"
 
-const int inArgs_DOESIKGROUPEXIST[]={
-    2,
+const int inArgs_SETJOINTPOSITIONS[]={
+    3,
     sim_script_arg_int32,0,
-    sim_script_arg_string,0,
+    sim_script_arg_int32|sim_script_arg_table,1,
+    sim_script_arg_double|sim_script_arg_table,1,
 };
 
-void LUA_DOESIKGROUPEXIST_CALLBACK(SScriptCallBack* p)
+void LUA_SETJOINTPOSITIONS_CALLBACK(SScriptCallBack* p)
 {
     CScriptFunctionData D;
-    bool retVal=false;
-    bool result=false;
-    if (D.readDataFromStack(p->stackID,inArgs_DOESIKGROUPEXIST,inArgs_DOESIKGROUPEXIST[0],LUA_DOESIKGROUPEXIST_COMMAND))
+    if (D.readDataFromStack(p->stackID,inArgs_SETJOINTPOSITIONS,inArgs_SETJOINTPOSITIONS[0],LUA_SETJOINTPOSITIONS_COMMAND))
     {
         std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
         int envId=inData->at(0).int32Data[0];
+        const std::vector<int>& jointHandles=inData->at(1).int32Data;
+        const std::vector<double>& positions=inData->at(2).doubleData;
         std::string err;
+        if (positions.size()==jointHandles.size())
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
-                retVal=ikDoesGroupExist(inData->at(1).stringData[0].c_str());
-                result=true;
+                for (size_t i=0;i<jointHandles.size();i++)
+                {
+                    if (!ikSetJointPosition(jointHandles[i],positions[i]))
+                    {
+                        err=_getLastError();
+                        break;
+                    }
+                }
             }
             else
-                 err=ikGetLastError();
+                err=_getLastError();
         }
+        else
+            err="invalid arguments";
         if (err.size()>0)
-            simSetLastError(LUA_DOESIKGROUPEXIST_COMMAND,err.c_str());
-    }
-    if (result)
-    {
-        D.pushOutData(CScriptFunctionDataItem(retVal));
-        D.writeDataToStack(p->stackID);
+            simSetLastError(LUA_SETJOINTPOSITIONS_COMMAND,err.c_str());
     }
 }
 // --------------------------------------------------------------------------------------
 
 // --------------------------------------------------------------------------------------
-// simIK.createGroup
+// simIK.getJointMatrices
 // --------------------------------------------------------------------------------------
-#define LUA_CREATEIKGROUP_COMMAND_PLUGIN "simIK.createGroup@IK"
-#define LUA_CREATEIKGROUP_COMMAND "simIK.createGroup"
+#define LUA_GETJOINTMATRICES_COMMAND_PLUGIN "simIK.getJointMatrices@IK"
+#define LUA_GETJOINTMATRICES_COMMAND "simIK.getJointMatrices"
 
-const int inArgs_CREATEIKGROUP[]={
+const int inArgs_GETJOINTMATRICES[]={
     2,
     sim_script_arg_int32,0,
-    sim_script_arg_string|SIM_SCRIPT_ARG_NULL_ALLOWED,0,
+    sim_script_arg_int32|sim_script_arg_table,1,
 };
 
-void LUA_CREATEIKGROUP_CALLBACK(SScriptCallBack* p)
+void LUA_GETJOINTMATRICES_CALLBACK(SScriptCallBack* p)
 {
     CScriptFunctionData D;
-    int retVal=-1;
+    std::vector<double> matrices;
     bool result=false;
-    if (D.readDataFromStack(p->stackID,inArgs_CREATEIKGROUP,inArgs_CREATEIKGROUP[0]-1,LUA_CREATEIKGROUP_COMMAND))
+    if (D.readDataFromStack(p->stackID,inArgs_GETJOINTMATRICES,inArgs_GETJOINTMATRICES[0],LUA_GETJOINTMATRICES_COMMAND))
     {
         std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
         int envId=inData->at(0).int32Data[0];
+        const std::vector<int>& jointHandles=inData->at(1).int32Data;
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
-                const char* nm=nullptr;
-                if ( (inData->size()>1)&&(inData->at(1).stringData.size()==1)&&(inData->at(1).stringData[0].size()>0) )
-                    nm=inData->at(1).stringData[0].c_str();
-                result=ikCreateGroup(nm,&retVal);
-                if (!result)
-                     err=ikGetLastError();
+                matrices.resize(jointHandles.size()*12);
+                result=true;
+                for (size_t i=0;i<jointHandles.size();i++)
+                {
+                    C7Vector tr;
+                    if (ikGetJointTransformation(jointHandles[i],&tr))
+                        tr.getMatrix().getData(&matrices[12*i]);
+                    else
+                    {
+                        err=_getLastError();
+                        result=false;
+                        break;
+                    }
+                }
             }
             else
-                 err=ikGetLastError();
+                err=_getLastError();
         }
         if (err.size()>0)
-            simSetLastError(LUA_CREATEIKGROUP_COMMAND,err.c_str());
+            simSetLastError(LUA_GETJOINTMATRICES_COMMAND,err.c_str());
     }
     if (result)
     {
-        D.pushOutData(CScriptFunctionDataItem(retVal));
+        D.pushOutData(CScriptFunctionDataItem(matrices));
         D.writeDataToStack(p->stackID);
     }
 }
 // --------------------------------------------------------------------------------------
 
 // --------------------------------------------------------------------------------------
-// simIK.getGroupFlags
+// simIK.setSphericalJointMatrices
 // --------------------------------------------------------------------------------------
-#define LUA_GETIKGROUPFLAGS_COMMAND_PLUGIN "simIK.getGroupFlags@IK"
-#define LUA_GETIKGROUPFLAGS_COMMAND "simIK.getGroupFlags"
+#define LUA_SETSPHERICALJOINTMATRICES_COMMAND_PLUGIN "simIK.setSphericalJointMatrices@IK"
+#define LUA_SETSPHERICALJOINTMATRICES_COMMAND "simIK.setSphericalJointMatrices"
+
+const int inArgs_SETSPHERICALJOINTMATRICES[]={
+    3,
+    sim_script_arg_int32,0,
+    sim_script_arg_int32|sim_script_arg_table,1,
+    sim_script_arg_double|sim_script_arg_table,12,
+};
+
+void LUA_SETSPHERICALJOINTMATRICES_CALLBACK(SScriptCallBack* p)
+{
+    CScriptFunctionData D;
+    if (D.readDataFromStack(p->stackID,inArgs_SETSPHERICALJOINTMATRICES,inArgs_SETSPHERICALJOINTMATRICES[0],LUA_SETSPHERICALJOINTMATRICES_COMMAND))
+    {
+        std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
+        int envId=inData->at(0).int32Data[0];
+        const std::vector<int>& jointHandles=inData->at(1).int32Data;
+        std::vector<double>& matrices=inData->at(2).doubleData;
+        std::string err;
+        if (matrices.size()==jointHandles.size()*12)
+        {
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
+            {
+                for (size_t i=0;i<jointHandles.size();i++)
+                {
+                    C4X4Matrix _m;
+                    _m.setData(&matrices[12*i]);
+                    C4Vector q(_m.M.getQuaternion());
+                    if (!ikSetSphericalJointQuaternion(jointHandles[i],&q))
+                    {
+                        err=_getLastError();
+                        break;
+                    }
+                }
+            }
+            else
+                err=_getLastError();
+        }
+        else
+            err="invalid arguments";
+        if (err.size()>0)
+            simSetLastError(LUA_SETSPHERICALJOINTMATRICES_COMMAND,err.c_str());
+    }
+}
+// --------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------
+// simIK.getGroupHandle
+// --------------------------------------------------------------------------------------
+#define LUA_GETIKGROUPHANDLE_COMMAND_PLUGIN "simIK.getGroupHandle@IK"
+#define LUA_GETIKGROUPHANDLE_COMMAND "simIK.getGroupHandle"
+
+const int inArgs_GETIKGROUPHANDLE[]={
+    2,
+    sim_script_arg_int32,0,
+    sim_script_arg_string,0,
+};
+
+void LUA_GETIKGROUPHANDLE_CALLBACK(SScriptCallBack* p)
+{
+    CScriptFunctionData D;
+    int retVal=-1;
+    bool result=false;
+    if (D.readDataFromStack(p->stackID,inArgs_GETIKGROUPHANDLE,inArgs_GETIKGROUPHANDLE[0],LUA_GETIKGROUPHANDLE_COMMAND))
+    {
+        std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
+        int envId=inData->at(0).int32Data[0];
+        std::string err;
+        {
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
+            {
+                result=ikGetGroupHandle(inData->at(1).stringData[0].c_str(),&retVal);
+                if (!result)
+                     err=_getLastError();
+            }
+            else
+                 err=_getLastError();
+        }
+        if (err.size()>0)
+            simSetLastError(LUA_GETIKGROUPHANDLE_COMMAND,err.c_str());
+    }
+    if (result)
+    {
+        D.pushOutData(CScriptFunctionDataItem(retVal));
+        D.writeDataToStack(p->stackID);
+    }
+}
+// --------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------
+// simIK.doesGroupExist
+// --------------------------------------------------------------------------------------
+#define LUA_DOESIKGROUPEXIST_COMMAND_PLUGIN "simIK.doesGroupExist@IK"
+#define LUA_DOESIKGROUPEXIST_COMMAND "simIK.doesGroupExist"
+
+const int inArgs_DOESIKGROUPEXIST[]={
+    2,
+    sim_script_arg_int32,0,
+    sim_script_arg_string,0,
+};
+
+void LUA_DOESIKGROUPEXIST_CALLBACK(SScriptCallBack* p)
+{
+    CScriptFunctionData D;
+    bool retVal=false;
+    bool result=false;
+    if (D.readDataFromStack(p->stackID,inArgs_DOESIKGROUPEXIST,inArgs_DOESIKGROUPEXIST[0],LUA_DOESIKGROUPEXIST_COMMAND))
+    {
+        std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
+        int envId=inData->at(0).int32Data[0];
+        std::string err;
+        {
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
+            {
+                retVal=ikDoesGroupExist(inData->at(1).stringData[0].c_str());
+                result=true;
+            }
+            else
+                 err=_getLastError();
+        }
+        if (err.size()>0)
+            simSetLastError(LUA_DOESIKGROUPEXIST_COMMAND,err.c_str());
+    }
+    if (result)
+    {
+        D.pushOutData(CScriptFunctionDataItem(retVal));
+        D.writeDataToStack(p->stackID);
+    }
+}
+// --------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------
+// simIK.createGroup
+// --------------------------------------------------------------------------------------
+#define LUA_CREATEIKGROUP_COMMAND_PLUGIN "simIK.createGroup@IK"
+#define LUA_CREATEIKGROUP_COMMAND "simIK.createGroup"
+
+const int inArgs_CREATEIKGROUP[]={
+    2,
+    sim_script_arg_int32,0,
+    sim_script_arg_string|SIM_SCRIPT_ARG_NULL_ALLOWED,0,
+};
+
+void LUA_CREATEIKGROUP_CALLBACK(SScriptCallBack* p)
+{
+    CScriptFunctionData D;
+    int retVal=-1;
+    bool result=false;
+    if (D.readDataFromStack(p->stackID,inArgs_CREATEIKGROUP,inArgs_CREATEIKGROUP[0]-1,LUA_CREATEIKGROUP_COMMAND))
+    {
+        std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
+        int envId=inData->at(0).int32Data[0];
+        std::string err;
+        {
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
+            {
+                _invalidateEnvPool(envId); // topology change
+                const char* nm=nullptr;
+                if ( (inData->size()>1)&&(inData->at(1).stringData.size()==1)&&(inData->at(1).stringData[0].size()>0) )
+                    nm=inData->at(1).stringData[0].c_str();
+                result=ikCreateGroup(nm,&retVal);
+                if (!result)
+                     err=_getLastError();
+            }
+            else
+                 err=_getLastError();
+        }
+        if (err.size()>0)
+            simSetLastError(LUA_CREATEIKGROUP_COMMAND,err.c_str());
+    }
+    if (result)
+    {
+        D.pushOutData(CScriptFunctionDataItem(retVal));
+        D.writeDataToStack(p->stackID);
+    }
+}
+// --------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------
+// simIK.getGroupFlags
+// --------------------------------------------------------------------------------------
+#define LUA_GETIKGROUPFLAGS_COMMAND_PLUGIN "simIK.getGroupFlags@IK"
+#define LUA_GETIKGROUPFLAGS_COMMAND "simIK.getGroupFlags"
 
 const int inArgs_GETIKGROUPFLAGS[]={
     2,
@@ -2160,15 +2789,15 @@ void LUA_GETIKGROUPFLAGS_CALLBACK(SScriptCallBack* p)
         int ikGroupHandle=inData->at(1).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetGroupFlags(ikGroupHandle,&flags);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETIKGROUPFLAGS_COMMAND,err.c_str());
@@ -2205,15 +2834,16 @@ void LUA_SETIKGROUPFLAGS_CALLBACK(SScriptCallBack* p)
         int flags=inData->at(2).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
+                _invalidateEnvPool(envId); // topology change
                 bool result=ikSetGroupFlags(ikGroupHandle,flags);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_SETIKGROUPFLAGS_COMMAND,err.c_str());
@@ -2246,15 +2876,15 @@ void LUA_GETIKGROUPJOINTLIMITHITS_CALLBACK(SScriptCallBack* p)
         int ikGroupHandle=inData->at(1).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetGroupJointLimitHits(ikGroupHandle,&handles,&overshots);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETIKGROUPJOINTLIMITHITS_COMMAND,err.c_str());
@@ -2292,15 +2922,15 @@ void LUA_GETGROUPJOINTS_CALLBACK(SScriptCallBack* p)
         int ikGroupHandle=inData->at(1).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetGroupJoints(ikGroupHandle,&handles);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETGROUPJOINTS_COMMAND,err.c_str());
@@ -2339,15 +2969,15 @@ void LUA_GETIKGROUPCALCULATION_CALLBACK(SScriptCallBack* p)
         int ikGroupHandle=inData->at(1).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetGroupCalculation(ikGroupHandle,&method,&damping,&iterations);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETIKGROUPCALCULATION_COMMAND,err.c_str());
@@ -2390,15 +3020,16 @@ void LUA_SETIKGROUPCALCULATION_CALLBACK(SScriptCallBack* p)
         int iterations=inData->at(4).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
+                _invalidateEnvPool(envId); // topology change
                 bool result=ikSetGroupCalculation(ikGroupHandle,method,damping,iterations);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_SETIKGROUPCALCULATION_COMMAND,err.c_str());
@@ -2433,15 +3064,16 @@ void LUA_ADDIKELEMENT_CALLBACK(SScriptCallBack* p)
         int tipDummyHandle=inData->at(2).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
+                _invalidateEnvPool(envId); // topology change
                 result=ikAddElement(ikGroupHandle,tipDummyHandle,&elementHandle);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_ADDIKELEMENT_COMMAND,err.c_str());
@@ -2480,15 +3112,15 @@ void LUA_GETIKELEMENTFLAGS_CALLBACK(SScriptCallBack* p)
         int ikElementHandle=inData->at(2).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetElementFlags(ikGroupHandle,ikElementHandle,&flags);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETIKELEMENTFLAGS_COMMAND,err.c_str());
@@ -2527,15 +3159,16 @@ void LUA_SETIKELEMENTFLAGS_CALLBACK(SScriptCallBack* p)
         int flags=inData->at(3).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
+                _invalidateEnvPool(envId); // topology change
                 bool result=ikSetElementFlags(ikGroupHandle,ikElementHandle,flags);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_SETIKELEMENTFLAGS_COMMAND,err.c_str());
@@ -2570,15 +3203,15 @@ void LUA_GETIKELEMENTBASE_CALLBACK(SScriptCallBack* p)
         int ikElementHandle=inData->at(2).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetElementBase(ikGroupHandle,ikElementHandle,&baseHandle,&constrBaseHandle);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETIKELEMENTBASE_COMMAND,err.c_str());
@@ -2622,15 +3255,16 @@ void LUA_SETIKELEMENTBASE_CALLBACK(SScriptCallBack* p)
             constrBaseHandle=inData->at(4).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
+                _invalidateEnvPool(envId); // topology change
                 bool result=ikSetElementBase(ikGroupHandle,ikElementHandle,baseHandle,constrBaseHandle);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_SETIKELEMENTBASE_COMMAND,err.c_str());
@@ -2664,15 +3298,15 @@ void LUA_GETIKELEMENTCONSTRAINTS_CALLBACK(SScriptCallBack* p)
         int ikElementHandle=inData->at(2).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetElementConstraints(ikGroupHandle,ikElementHandle,&constraints);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETIKELEMENTCONSTRAINTS_COMMAND,err.c_str());
@@ -2711,15 +3345,16 @@ void LUA_SETIKELEMENTCONSTRAINTS_CALLBACK(SScriptCallBack* p)
         int constraints=inData->at(3).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
+                _invalidateEnvPool(envId); // topology change
                 bool result=ikSetElementConstraints(ikGroupHandle,ikElementHandle,constraints);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_SETIKELEMENTCONSTRAINTS_COMMAND,err.c_str());
@@ -2753,15 +3388,15 @@ void LUA_GETIKELEMENTPRECISION_CALLBACK(SScriptCallBack* p)
         int ikElementHandle=inData->at(2).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetElementPrecision(ikGroupHandle,ikElementHandle,precision+0,precision+1);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETIKELEMENTPRECISION_COMMAND,err.c_str());
@@ -2801,15 +3436,16 @@ void LUA_SETIKELEMENTPRECISION_CALLBACK(SScriptCallBack* p)
         double* precision=&inData->at(3).doubleData[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
+                _invalidateEnvPool(envId); // topology change
                 bool result=ikSetElementPrecision(ikGroupHandle,ikElementHandle,precision[0],precision[1]);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_SETIKELEMENTPRECISION_COMMAND,err.c_str());
@@ -2843,15 +3479,15 @@ void LUA_GETIKELEMENTWEIGHTS_CALLBACK(SScriptCallBack* p)
         int ikElementHandle=inData->at(2).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 result=ikGetElementWeights(ikGroupHandle,ikElementHandle,weights+0,weights+1);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETIKELEMENTWEIGHTS_COMMAND,err.c_str());
@@ -2897,15 +3533,16 @@ void LUA_SETIKELEMENTWEIGHTS_CALLBACK(SScriptCallBack* p)
             weights[2]=1.0;
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
+                _invalidateEnvPool(envId); // topology change
                 bool result=ikSetElementWeights(ikGroupHandle,ikElementHandle,weights[0],weights[1],weights[2]);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_SETIKELEMENTWEIGHTS_COMMAND,err.c_str());
@@ -2914,26 +3551,46 @@ void LUA_SETIKELEMENTWEIGHTS_CALLBACK(SScriptCallBack* p)
 // --------------------------------------------------------------------------------------
 
 // --------------------------------------------------------------------------------------
-static std::string jacobianCallback_funcName;
-static int jacobianCallback_scriptHandle;
-static int jacobianCallback_envId;
-
 int jacobianCallback(const int jacobianSize[2],double* jacobian,const int* rowConstraints,const int* rowIkElements,const int* colHandles,const int* colStages,double* errorVector,double* qVector,double* jacobianPinv,int groupHandle,int iteration)
 {
-    unlockInterface(); // actually required to correctly support CoppeliaSim's old GUI-based IK
+    CEnvContext* ctx=CEnvContext::current();
+    ctx->beginScriptCallback();
     int retVal=-1; // error, -2 is nan error (ik_calc_invalidcallbackdata)
-    int stack=simCreateStack();
+    int stack=ctx->jacobianCallback.func.createStack();
+    int rows=jacobianSize[0];
     int cols=jacobianSize[1];
-    simPushInt32TableOntoStack(stack,rowConstraints,jacobianSize[0]);
-    simPushInt32TableOntoStack(stack,rowIkElements,jacobianSize[0]);
-    simPushInt32TableOntoStack(stack,colHandles,cols);
-    simPushInt32TableOntoStack(stack,colStages,cols);
+    // row and column metadata rarely changes between iterations: send it only when it did, nil otherwise
+    std::vector<int>& sent=ctx->jacobianCallback.sentRowsAndCols;
+    bool metadataChanged=( (groupHandle!=ctx->jacobianCallback.sentGroupHandle)||(sent.size()!=size_t(2*(rows+cols))) );
+    metadataChanged=metadataChanged||(!std::equal(rowConstraints,rowConstraints+rows,sent.begin()));
+    metadataChanged=metadataChanged||(!std::equal(rowIkElements,rowIkElements+rows,sent.begin()+rows));
+    metadataChanged=metadataChanged||(!std::equal(colHandles,colHandles+cols,sent.begin()+2*rows));
+    metadataChanged=metadataChanged||(!std::equal(colStages,colStages+cols,sent.begin()+2*rows+cols));
+    if (metadataChanged)
+    {
+        sent.assign(rowConstraints,rowConstraints+rows);
+        sent.insert(sent.end(),rowIkElements,rowIkElements+rows);
+        sent.insert(sent.end(),colHandles,colHandles+cols);
+        sent.insert(sent.end(),colStages,colStages+cols);
+        ctx->jacobianCallback.sentGroupHandle=groupHandle;
+        simPushInt32TableOntoStack(stack,rowConstraints,rows);
+        simPushInt32TableOntoStack(stack,rowIkElements,rows);
+        simPushInt32TableOntoStack(stack,colHandles,cols);
+        simPushInt32TableOntoStack(stack,colStages,cols);
+    }
+    else
+    {
+        for (size_t i=0;i<4;i++)
+            simPushNullOntoStack(stack);
+    }
     simPushDoubleTableOntoStack(stack,jacobian,jacobianSize[0]*jacobianSize[1]);
     simPushDoubleTableOntoStack(stack,errorVector,jacobianSize[0]);
     simPushInt32OntoStack(stack,groupHandle);
     simPushInt32OntoStack(stack,iteration);
-    if (simCallScriptFunctionEx(jacobianCallback_scriptHandle,jacobianCallback_funcName.c_str(),stack)!=-1)
+    if (ctx->jacobianCallback.func.call(stack))
     {
+        while ( (simGetStackSize(stack)>=0)&&(simGetStackSize(stack)<4) )
+            simPushNullOntoStack(stack); // nil (or omitted) return values leave the corresponding data unchanged
         if (simGetStackSize(stack)==4)
         {
             retVal=0;
@@ -2973,10 +3630,19 @@ int jacobianCallback(const int jacobianSize[2],double* jacobian,const int* rowCo
         }
     }
     simReleaseStack(stack);
-    lockInterface(); // actually required to correctly support CoppeliaSim's old GUI-based IK
-    ikSwitchEnvironment(jacobianCallback_envId); // actually required to correctly support CoppeliaSim's old GUI-based IK
+    ctx->endScriptCallback();
+    return(retVal);
+}
+int _getResultFromCalcFlags(int ikRes)
+{
+    int retVal=1; // previously ik_result_success
+    if ( (ikRes&ik_calc_notperformed)!=0 )
+        retVal=0; // ik_result_not_performed
+    else if ( (ikRes&(ik_calc_cannotinvert|ik_calc_notwithintolerance))!=0 )
+        retVal=2; // previously ik_result_fail
     return(retVal);
 }
+
 // --------------------------------------------------------------------------------------
 // simIK._handleGroups
 // --------------------------------------------------------------------------------------
@@ -2987,7 +3653,7 @@ const int inArgs_HANDLEIKGROUPS[]={
     4,
     sim_script_arg_int32,0,
     sim_script_arg_int32|sim_script_arg_table,1,
-    sim_script_arg_string|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // cb func name
+    sim_script_arg_int32|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // cb reference
     sim_script_arg_int32|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // script handle of cb
 };
 
@@ -3004,38 +3670,30 @@ void LUA_HANDLEIKGROUPS_CALLBACK(SScriptCallBack* p)
         std::vector<int>* ikGroupHandles=nullptr; // means handle all
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 int(*cb)(const int*,double*,const int*,const int*,const int*,const int*,double*,double*,double*,int,int)=nullptr;
                 if ( (inData->size()>1)&&(inData->at(1).int32Data.size()>=1) )
                     ikGroupHandles=&inData->at(1).int32Data;
-                if ( (inData->size()>3)&&(inData->at(2).stringData.size()==1)&&(inData->at(2).stringData[0].size()>0)&&(inData->at(3).int32Data.size()==1) )
+                if ( (inData->size()>3)&&(inData->at(2).int32Data.size()==1)&&(inData->at(3).int32Data.size()==1) )
                 {
-                    jacobianCallback_funcName=inData->at(2).stringData[0];
-                    jacobianCallback_scriptHandle=inData->at(3).int32Data[0];
-                    jacobianCallback_envId=envId;
+                    ctx.jacobianCallback.func.set(inData->at(3).int32Data[0],inData->at(2).int32Data[0]);
                     cb=jacobianCallback;
                 }
                 result=ikHandleGroups(ikGroupHandles,&ikRes,precision,cb);
                 if (!result)
-                    err=ikGetLastError();
+                    err=_getLastError();
             }
             else
-                err=ikGetLastError();
+                err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_HANDLEIKGROUPS_COMMAND,err.c_str());
     }
     if (result)
     {
-        int r=ikRes;
-        if ( (r&ik_calc_notperformed)!=0 )
-            r=0; // ik_result_not_performed
-        else if ( (r&(ik_calc_cannotinvert|ik_calc_notwithintolerance))!=0 )
-            r=2; // previously ik_result_fail
-        else r=1; // previously ik_result_success
-        D.pushOutData(CScriptFunctionDataItem(r));
+        D.pushOutData(CScriptFunctionDataItem(_getResultFromCalcFlags(ikRes)));
         D.pushOutData(CScriptFunctionDataItem(ikRes));
         std::vector<double> prec(precision,precision+2);
         D.pushOutData(CScriptFunctionDataItem(prec));
@@ -3044,200 +3702,1891 @@ void LUA_HANDLEIKGROUPS_CALLBACK(SScriptCallBack* p)
 }
 // --------------------------------------------------------------------------------------
 
-static std::string validationCallback_funcNameAtScriptName;
-static int validationCallback_scriptType;
-static int validationCallback_envId;
-static size_t validationCallback_jointCnt;
-
-bool validationCallback(double* conf)
-{
-    unlockInterface(); // actually required to correctly support CoppeliaSim's old GUI-based IK
-    bool retVal=1;
-    int stack=simCreateStack();
-    simPushDoubleTableOntoStack(stack,conf,int(validationCallback_jointCnt));
-    if (simCallScriptFunctionEx(validationCallback_scriptType,validationCallback_funcNameAtScriptName.c_str(),stack)!=-1)
-        simGetStackBoolValue(stack,&retVal);
-    simReleaseStack(stack);
-    lockInterface(); // actually required to correctly support CoppeliaSim's old GUI-based IK
-    ikSwitchEnvironment(validationCallback_envId); // actually required to correctly support CoppeliaSim's old GUI-based IK
-    return(retVal!=0);
-}
-
 // --------------------------------------------------------------------------------------
-// simIK._getConfigForTipPose // deprecated
+// simIK._handleGroupsMulti
 // --------------------------------------------------------------------------------------
-#define LUA_GETCONFIGFORTIPPOSE_COMMAND_PLUGIN "simIK._getConfigForTipPose@IK"
-#define LUA_GETCONFIGFORTIPPOSE_COMMAND "simIK._getConfigForTipPose"
+#define LUA_HANDLEIKGROUPSMULTI_COMMAND_PLUGIN "simIK._handleGroupsMulti@IK"
+#define LUA_HANDLEIKGROUPSMULTI_COMMAND "simIK._handleGroupsMulti"
 
-const int inArgs_GETCONFIGFORTIPPOSE[]={
-    11,
-    sim_script_arg_int32,0,
-    sim_script_arg_int32,0,
-    sim_script_arg_int32|sim_script_arg_table,0,
-    sim_script_arg_double|SIM_SCRIPT_ARG_NULL_ALLOWED,0,
-    sim_script_arg_int32|SIM_SCRIPT_ARG_NULL_ALLOWED,0,
-    sim_script_arg_double|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,4,
-    sim_script_arg_string|SIM_SCRIPT_ARG_NULL_ALLOWED,0,
-    sim_script_arg_int32|SIM_SCRIPT_ARG_NULL_ALLOWED,0,
-    sim_script_arg_int32|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,0,
-    sim_script_arg_double|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,0,
-    sim_script_arg_double|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,0,
+const int inArgs_HANDLEIKGROUPSMULTI[]={
+    3,
+    sim_script_arg_int32|sim_script_arg_table,1, // environment handles
+    sim_script_arg_int32|sim_script_arg_table,1, // group count for each environment, 0 means all groups
+    sim_script_arg_int32|sim_script_arg_table,0, // group handles of all environments, concatenated
 };
 
-void LUA_GETCONFIGFORTIPPOSE_CALLBACK(SScriptCallBack* p)
-{
+void LUA_HANDLEIKGROUPSMULTI_CALLBACK(SScriptCallBack* p)
+{ // entries are handled sequentially: the kinematics routines have a single current environment
     CScriptFunctionData D;
-    int calcResult=-1;
-    double* retConfig=nullptr;
-    size_t jointCnt=0;
-    if (D.readDataFromStack(p->stackID,inArgs_GETCONFIGFORTIPPOSE,inArgs_GETCONFIGFORTIPPOSE[0]-8,LUA_GETCONFIGFORTIPPOSE_COMMAND))
+    std::vector<int> results;
+    std::vector<int> reasons;
+    std::vector<double> precisions;
+    bool result=false;
+    if (D.readDataFromStack(p->stackID,inArgs_HANDLEIKGROUPSMULTI,inArgs_HANDLEIKGROUPSMULTI[0],LUA_HANDLEIKGROUPSMULTI_COMMAND))
     {
         std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
-        int envId=inData->at(0).int32Data[0];
-        int ikGroupHandle=inData->at(1).int32Data[0];
+        const std::vector<int>& envIds=inData->at(0).int32Data;
+        const std::vector<int>& groupCounts=inData->at(1).int32Data;
+        const std::vector<int>& groupHandles=inData->at(2).int32Data;
         std::string err;
+        if (groupCounts.size()==envIds.size())
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            result=true;
+            size_t groupOffset=0;
+            for (size_t i=0;i<envIds.size();i++)
             {
-                jointCnt=inData->at(2).int32Data.size();
-                if (jointCnt>0)
+                size_t groupCnt=size_t(std::max<int>(groupCounts[i],0));
+                if (groupOffset+groupCnt>groupHandles.size())
                 {
-                    retConfig=new double[jointCnt];
-                    double thresholdDist=double(0.1);
-                    int iterations=1000;
-                    double* metric=nullptr;
-                    int* jointOptions=nullptr;
-                    double* lowLimits=nullptr;
-                    double* ranges=nullptr;
-                    bool(*cb)(double*)=nullptr;
-                    int scriptType=sim_scripttype_childscript;
-                    if ( (inData->size()>4)&&(inData->at(4).int32Data.size()==1) )
-                        iterations=inData->at(4).int32Data[0];
-                    if ( (inData->size()>8)&&(inData->at(8).int32Data.size()>=jointCnt) )
-                        jointOptions=&inData->at(8).int32Data[0];
-                    if ( (inData->size()>7)&&(inData->at(7).int32Data.size()==1) )
-                        scriptType=inData->at(7).int32Data[0];
-                    if ( (inData->size()>6)&&(inData->at(6).stringData.size()==1)&&(inData->at(6).stringData[0].size()>0) )
+                    err="invalid arguments";
+                    result=false;
+                    break;
+                }
+                std::vector<int> groups(groupHandles.begin()+groupOffset,groupHandles.begin()+groupOffset+groupCnt);
+                groupOffset+=groupCnt;
+                int ikRes=ik_result_not_performed;
+                double precision[2]={0.0,0.0};
+                std::string entryErr;
+                {
+                    CEnvContext ctx(envIds[i]);
+                    if (ctx.isValid())
                     {
-                        validationCallback_funcNameAtScriptName=inData->at(6).stringData[0];
-                        validationCallback_scriptType=scriptType;
-                        validationCallback_jointCnt=jointCnt;
-                        validationCallback_envId=envId;
-                        cb=validationCallback;
+                        std::vector<int>* ikGroupHandles=nullptr; // means handle all
+                        if (groupCnt>0)
+                            ikGroupHandles=&groups;
+                        if (!ikHandleGroups(ikGroupHandles,&ikRes,precision))
+                            entryErr=_getLastError();
                     }
-                    if ( (inData->size()>3)&&(inData->at(3).doubleData.size()==1) )
-                        thresholdDist=inData->at(3).doubleData[0];
-                    if ( (inData->size()>5)&&(inData->at(5).doubleData.size()>=4) )
-                        metric=&inData->at(5).doubleData[0];
-                    if ( (inData->size()>9)&&(inData->at(9).doubleData.size()>=jointCnt) )
-                        lowLimits=&inData->at(9).doubleData[0];
-                    if ( (inData->size()>10)&&(inData->at(10).doubleData.size()>=jointCnt) )
-                        ranges=&inData->at(10).doubleData[0];
-                    calcResult=ikGetConfigForTipPose(ikGroupHandle,jointCnt,&inData->at(2).int32Data[0],thresholdDist,iterations,retConfig,metric,cb,jointOptions,lowLimits,ranges);
-                    if (calcResult==-1)
-                         err=ikGetLastError();
+                    else
+                        entryErr=_getLastError();
                 }
-                else
-                    err="invalid joint handles";
+                if (entryErr.size()>0)
+                { // a bad entry does not affect the others: it gets result -1, and the error is logged
+                    std::string msg("entry ");
+                    msg+=std::to_string(i+1)+": "+entryErr;
+                    simAddLog("IK",sim_verbosity_scriptwarnings,msg.c_str());
+                    results.push_back(-1);
+                    reasons.push_back(0);
+                    precisions.push_back(0.0);
+                    precisions.push_back(0.0);
+                    continue;
+                }
+                results.push_back(_getResultFromCalcFlags(ikRes));
+                reasons.push_back(ikRes);
+                precisions.push_back(precision[0]);
+                precisions.push_back(precision[1]);
             }
-            else
-                 err=ikGetLastError();
         }
+        else
+            err="invalid arguments";
         if (err.size()>0)
-            simSetLastError(LUA_GETCONFIGFORTIPPOSE_COMMAND,err.c_str());
+            simSetLastError(LUA_HANDLEIKGROUPSMULTI_COMMAND,err.c_str());
     }
-    if (calcResult==1)
+    if (result)
     {
-        std::vector<double> v(retConfig,retConfig+jointCnt);
+        D.pushOutData(CScriptFunctionDataItem(results));
+        D.pushOutData(CScriptFunctionDataItem(reasons));
+        D.pushOutData(CScriptFunctionDataItem(precisions));
+        D.writeDataToStack(p->stackID);
+    }
+}
+// --------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------
+// simIK._setSyncGroup
+// --------------------------------------------------------------------------------------
+#define LUA_SETSYNCGROUP_COMMAND_PLUGIN "simIK._setSyncGroup@IK"
+#define LUA_SETSYNCGROUP_COMMAND "simIK._setSyncGroup"
+
+const int inArgs_SETSYNCGROUP[]={
+    5,
+    sim_script_arg_int32,0,
+    sim_script_arg_int32,0,
+    sim_script_arg_int32|sim_script_arg_table,0, // sim joints
+    sim_script_arg_int32|sim_script_arg_table,0, // corresponding IK joints
+    sim_script_arg_int32|sim_script_arg_table,0, // sim target, sim base, IK target, IK base quadruplets
+};
+
+void LUA_SETSYNCGROUP_CALLBACK(SScriptCallBack* p)
+{
+    CScriptFunctionData D;
+    if (D.readDataFromStack(p->stackID,inArgs_SETSYNCGROUP,inArgs_SETSYNCGROUP[0],LUA_SETSYNCGROUP_COMMAND))
+    {
+        std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
+        int envId=inData->at(0).int32Data[0];
+        int ikGroupHandle=inData->at(1).int32Data[0];
+        const std::vector<int>& simJoints=inData->at(2).int32Data;
+        const std::vector<int>& ikJoints=inData->at(3).int32Data;
+        const std::vector<int>& targets=inData->at(4).int32Data;
+        std::string err;
+        if ( (simJoints.size()==ikJoints.size())&&((targets.size()%4)==0) )
+        {
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
+            {
+                SSyncGroup groupData;
+                for (size_t i=0;i<simJoints.size();i++)
+                {
+                    SSyncJoint joint;
+                    joint.simJoint=simJoints[i];
+                    joint.ikJoint=ikJoints[i];
+                    joint.spherical=(simGetJointType(joint.simJoint)==sim_joint_spherical_subtype);
+                    groupData.joints.push_back(joint);
+                }
+                for (size_t i=0;i<targets.size()/4;i++)
+                {
+                    SSyncTarget target;
+                    target.simTarget=targets[4*i+0];
+                    target.simBase=targets[4*i+1];
+                    target.ikTarget=targets[4*i+2];
+                    target.ikBase=targets[4*i+3];
+                    target.syncedMatrixValid=false;
+                    groupData.targets.push_back(target);
+                }
+                _allSyncGroups->setGroup(envId,ikGroupHandle,groupData);
+            }
+            else
+                err=_getLastError();
+        }
+        else
+            err="invalid arguments";
+        if (err.size()>0)
+            simSetLastError(LUA_SETSYNCGROUP_COMMAND,err.c_str());
+    }
+}
+// --------------------------------------------------------------------------------------
+
+static const double _syncMatrixTolerance=1e-10; // absorbs the round-off of matrix/quaternion conversions
+
+double _getMaxAbsDiff(const double* a,const double* b,size_t n)
+{
+    double retVal=0.0;
+    for (size_t i=0;i<n;i++)
+        retVal=std::max<double>(retVal,fabs(a[i]-b[i]));
+    return(retVal);
+}
+
+static bool _isMovedByJoints(int objectHandle)
+{ // call with the environment context set. Whether a joint is among the ancestors of the object
+    while (objectHandle>=0)
+    {
+        int parentHandle;
+        int objectType;
+        if (!ikGetObjectParent(objectHandle,&parentHandle))
+            return(true);
+        if ( (parentHandle>=0)&&( (!ikGetObjectType(parentHandle,&objectType))||(objectType==ik_objecttype_joint) ) )
+            return(true);
+        objectHandle=parentHandle;
+    }
+    return(false);
+}
+
+bool _syncGroupsFromSim(int envId,const std::vector<int>& ikGroupHandles,double tolerance,std::vector<int>& removedSimJoints,std::string& err)
+{ // call with the environment context set. Only values that differ from the IK side by more than tolerance are pushed.
+  // Targets whose scene pose did not change since the last sync are skipped, unless the IK side could have moved them
+    double matrixTolerance=std::max<double>(tolerance,_syncMatrixTolerance);
+    for (size_t g=0;g<ikGroupHandles.size();g++)
+    {
+        SSyncGroup* groupData=_allSyncGroups->getGroup(envId,ikGroupHandles[g]);
+        if (groupData==nullptr)
+        {
+            err="IK group was not built with simIK.addElementFromScene";
+            return(false);
+        }
+        size_t i=0;
+        while (i<groupData->joints.size())
+        {
+            SSyncJoint& joint=groupData->joints[i];
+            if (simIsHandle(joint.simJoint,sim_appobj_object_type)>0)
+            {
+                bool ok=true;
+                if (joint.spherical)
+                {
+                    double simM[12];
+                    simGetJointMatrix(joint.simJoint,simM);
+                    C7Vector tr;
+                    bool changed=true;
+                    if (ikGetJointTransformation(joint.ikJoint,&tr))
+                    {
+                        double m[12];
+                        tr.getMatrix().getData(m);
+                        changed=(_getMaxAbsDiff(simM,m,12)>matrixTolerance);
+                    }
+                    if (changed)
+                    {
+                        C4X4Matrix _m;
+                        _m.setData(simM);
+                        C4Vector q(_m.M.getQuaternion());
+                        ok=ikSetSphericalJointQuaternion(joint.ikJoint,&q);
+                    }
+                }
+                else
+                {
+                    double simPos;
+                    simGetJointPosition(joint.simJoint,&simPos);
+                    double pos;
+                    if ( (!ikGetJointPosition(joint.ikJoint,&pos))||(fabs(simPos-pos)>tolerance) )
+                        ok=ikSetJointPosition(joint.ikJoint,simPos);
+                }
+                if (!ok)
+                {
+                    err=_getLastError();
+                    return(false);
+                }
+                i++;
+            }
+            else
+            { // that is probably a joint in a dependency relation, that was removed
+                int simJoint=joint.simJoint;
+                _eraseObject(envId,joint.ikJoint);
+                _allSyncGroups->removeJoint(envId,simJoint);
+                removedSimJoints.push_back(simJoint);
+            }
+        }
+        for (size_t i=0;i<groupData->targets.size();i++)
+        { // make sure target relative to base is in sync too
+            SSyncTarget& target=groupData->targets[i];
+            double m[12];
+            simGetObjectMatrix(target.simTarget,target.simBase,m);
+            if ( target.syncedMatrixValid&&(_getMaxAbsDiff(m,target.syncedMatrix,12)<=matrixTolerance) )
+                continue; // neither side moved since the last sync
+            C7Vector tr;
+            bool changed=true;
+            if (ikGetObjectTransformation(target.ikTarget,target.ikBase,&tr))
+            {
+                double ikM[12];
+                tr.getMatrix().getData(ikM);
+                changed=(_getMaxAbsDiff(m,ikM,12)>matrixTolerance);
+            }
+            if (changed)
+            {
+                C4X4Matrix _m;
+                _m.setData(m);
+                tr=_m.getTransformation();
+                if (!ikSetObjectTransformation(target.ikTarget,target.ikBase,&tr))
+                {
+                    err=_getLastError();
+                    return(false);
+                }
+            }
+            for (size_t j=0;j<12;j++)
+                target.syncedMatrix[j]=m[j];
+            // when joints move the target relative to its base on the IK side, IK calculations change the IK pose too:
+            target.syncedMatrixValid=( (!_isMovedByJoints(target.ikTarget))&&(!_isMovedByJoints(target.ikBase)) );
+        }
+    }
+    return(true);
+}
+
+bool _syncGroupsToSim(int envId,const std::vector<int>& ikGroupHandles,double tolerance,std::vector<int>& removedSimJoints,std::string& err)
+{ // call with the environment context set. Only joints that differ from the current scene value by more than tolerance
+  // are written back, so that values written to the scene by others in the mean time are also corrected
+    double matrixTolerance=std::max<double>(tolerance,_syncMatrixTolerance);
+    for (size_t g=0;g<ikGroupHandles.size();g++)
+    {
+        SSyncGroup* groupData=_allSyncGroups->getGroup(envId,ikGroupHandles[g]);
+        if (groupData==nullptr)
+        {
+            err="IK group was not built with simIK.addElementFromScene";
+            return(false);
+        }
+        size_t i=0;
+        while (i<groupData->joints.size())
+        {
+            SSyncJoint& joint=groupData->joints[i];
+            if (simIsHandle(joint.simJoint,sim_appobj_object_type)>0)
+            {
+                int jointOptions;
+                bool dynamic=( (simGetJointMode(joint.simJoint,&jointOptions)==sim_jointmode_force)&&(simIsDynamicallyEnabled(joint.simJoint)>0) );
+                if (joint.spherical)
+                {
+                    if (!dynamic)
+                    {
+                        C7Vector tr;
+                        if (!ikGetJointTransformation(joint.ikJoint,&tr))
+                        {
+                            err=_getLastError();
+                            return(false);
+                        }
+                        double m[12];
+                        tr.getMatrix().getData(m);
+                        double simM[12];
+                        if ( (simGetJointMatrix(joint.simJoint,simM)==-1)||(_getMaxAbsDiff(simM,m,12)>matrixTolerance) )
+                            simSetSphericalJointMatrix(joint.simJoint,m);
+                    }
+                }
+                else
+                {
+                    double pos;
+                    if (!ikGetJointPosition(joint.ikJoint,&pos))
+                    {
+                        err=_getLastError();
+                        return(false);
+                    }
+                    double simPos;
+                    if (dynamic)
+                    {
+                        if ( (simGetJointTargetPosition(joint.simJoint,&simPos)==-1)||(fabs(simPos-pos)>tolerance) )
+                            simSetJointTargetPosition(joint.simJoint,pos);
+                    }
+                    else
+                    {
+                        if ( (simGetJointPosition(joint.simJoint,&simPos)==-1)||(fabs(simPos-pos)>tolerance) )
+                            simSetJointPosition(joint.simJoint,pos);
+                    }
+                }
+                i++;
+            }
+            else
+            { // that is probably a joint in a dependency relation, that was removed
+                int simJoint=joint.simJoint;
+                _eraseObject(envId,joint.ikJoint);
+                _allSyncGroups->removeJoint(envId,simJoint);
+                removedSimJoints.push_back(simJoint);
+            }
+        }
+    }
+    return(true);
+}
+
+// --------------------------------------------------------------------------------------
+// simIK._syncFromSim
+// --------------------------------------------------------------------------------------
+#define LUA_SYNCFROMSIM_COMMAND_PLUGIN "simIK._syncFromSim@IK"
+#define LUA_SYNCFROMSIM_COMMAND "simIK._syncFromSim"
+
+const int inArgs_SYNCFROMSIM[]={
+    3,
+    sim_script_arg_int32,0,
+    sim_script_arg_int32|sim_script_arg_table,0,
+    sim_script_arg_double,0, // tolerance
+};
+
+void LUA_SYNCFROMSIM_CALLBACK(SScriptCallBack* p)
+{
+    CScriptFunctionData D;
+    std::vector<int> removedSimJoints;
+    bool result=false;
+    if (D.readDataFromStack(p->stackID,inArgs_SYNCFROMSIM,inArgs_SYNCFROMSIM[0]-1,LUA_SYNCFROMSIM_COMMAND))
+    {
+        std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
+        int envId=inData->at(0).int32Data[0];
+        double tolerance=0.0;
+        if ( (inData->size()>2)&&(inData->at(2).doubleData.size()==1) )
+            tolerance=inData->at(2).doubleData[0];
+        std::string err;
+        {
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
+                result=_syncGroupsFromSim(envId,inData->at(1).int32Data,tolerance,removedSimJoints,err);
+            else
+                err=_getLastError();
+        }
+        if (err.size()>0)
+            simSetLastError(LUA_SYNCFROMSIM_COMMAND,err.c_str());
+    }
+    if (result)
+    {
+        D.pushOutData(CScriptFunctionDataItem(removedSimJoints));
+        D.writeDataToStack(p->stackID);
+    }
+}
+// --------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------
+// simIK._syncToSim
+// --------------------------------------------------------------------------------------
+#define LUA_SYNCTOSIM_COMMAND_PLUGIN "simIK._syncToSim@IK"
+#define LUA_SYNCTOSIM_COMMAND "simIK._syncToSim"
+
+const int inArgs_SYNCTOSIM[]={
+    3,
+    sim_script_arg_int32,0,
+    sim_script_arg_int32|sim_script_arg_table,0,
+    sim_script_arg_double,0, // tolerance
+};
+
+void LUA_SYNCTOSIM_CALLBACK(SScriptCallBack* p)
+{
+    CScriptFunctionData D;
+    std::vector<int> removedSimJoints;
+    bool result=false;
+    if (D.readDataFromStack(p->stackID,inArgs_SYNCTOSIM,inArgs_SYNCTOSIM[0]-1,LUA_SYNCTOSIM_COMMAND))
+    {
+        std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
+        int envId=inData->at(0).int32Data[0];
+        double tolerance=0.0;
+        if ( (inData->size()>2)&&(inData->at(2).doubleData.size()==1) )
+            tolerance=inData->at(2).doubleData[0];
+        std::string err;
+        {
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
+                result=_syncGroupsToSim(envId,inData->at(1).int32Data,tolerance,removedSimJoints,err);
+            else
+                err=_getLastError();
+        }
+        if (err.size()>0)
+            simSetLastError(LUA_SYNCTOSIM_COMMAND,err.c_str());
+    }
+    if (result)
+    {
+        D.pushOutData(CScriptFunctionDataItem(removedSimJoints));
+        D.writeDataToStack(p->stackID);
+    }
+}
+// --------------------------------------------------------------------------------------
+
+bool validationCallback(double* conf)
+{
+    CEnvContext* ctx=CEnvContext::current();
+    ctx->beginScriptCallback();
+    bool retVal=1;
+    int stack=ctx->validationCallback.func.createStack();
+    simPushDoubleTableOntoStack(stack,conf,int(ctx->validationCallback.jointCnt));
+    if (ctx->validationCallback.func.call(stack))
+        simGetStackBoolValue(stack,&retVal);
+    simReleaseStack(stack);
+    ctx->endScriptCallback();
+    return(retVal!=0);
+}
+
+static bool _setupNativeValidator(std::vector<CScriptFunctionDataItem>* inData,size_t argIndex,const std::vector<int>& jointHandles,CConfigValidator& validator,std::string& err)
+{ // validator types, int parameters, double parameters, scene joints and collision pairs are 5 consecutive optional arguments
+    std::vector<int> noInts;
+    std::vector<double> noDoubles;
+    const std::vector<int>* types=&noInts;
+    const std::vector<int>* ints=&noInts;
+    const std::vector<double>* doubles=&noDoubles;
+    const std::vector<int>* simJoints=&noInts;
+    const std::vector<int>* collisionPairs=&noInts;
+    if (inData->size()>argIndex)
+        types=&inData->at(argIndex).int32Data;
+    if (inData->size()>argIndex+1)
+        ints=&inData->at(argIndex+1).int32Data;
+    if (inData->size()>argIndex+2)
+        doubles=&inData->at(argIndex+2).doubleData;
+    if (inData->size()>argIndex+3)
+        simJoints=&inData->at(argIndex+3).int32Data;
+    if (inData->size()>argIndex+4)
+        collisionPairs=&inData->at(argIndex+4).int32Data;
+    return( validator.setup(*types,*ints,*doubles,jointHandles,err)&&validator.setCollisionCheck(*simJoints,*collisionPairs,err) );
+}
+
+bool nativeValidationCallback(double* conf)
+{
+    CEnvContext* ctx=CEnvContext::current();
+    if (!ctx->validationCallback.nativeValidator->isValid(conf))
+        return(false);
+    if (ctx->validationCallback.func.isSet())
+        return(validationCallback(conf));
+    return(true);
+}
+
+int validationCallbackBatch(const std::vector<double>& configs)
+{ // the script function receives the configurations as one flat table, and returns one validity flag (0 or 1) per
+  // configuration. Returns the index of the first valid configuration, or -1
+    CEnvContext* ctx=CEnvContext::current();
+    ctx->beginScriptCallback();
+    int retVal=-1;
+    int cnt=int(configs.size()/ctx->validationCallback.jointCnt);
+    int stack=ctx->validationCallback.func.createStack();
+    simPushDoubleTableOntoStack(stack,configs.data(),int(configs.size()));
+    if ( ctx->validationCallback.func.call(stack)&&(simGetStackSize(stack)>0)&&(simGetStackTableInfo(stack,0)==cnt) )
+    {
+        std::vector<int> valid(size_t(cnt),0);
+        simGetStackInt32Table(stack,&valid[0],cnt);
+        for (int i=0;(retVal==-1)&&(i<cnt);i++)
+        {
+            if (valid[size_t(i)]!=0)
+                retVal=i;
+        }
+    }
+    simReleaseStack(stack);
+    ctx->endScriptCallback();
+    return(retVal);
+}
+
+// --------------------------------------------------------------------------------------
+// simIK._getConfigForTipPose // deprecated
+// --------------------------------------------------------------------------------------
+#define LUA_GETCONFIGFORTIPPOSE_COMMAND_PLUGIN "simIK._getConfigForTipPose@IK"
+#define LUA_GETCONFIGFORTIPPOSE_COMMAND "simIK._getConfigForTipPose"
+
+const int inArgs_GETCONFIGFORTIPPOSE[]={
+    13,
+    sim_script_arg_int32,0,
+    sim_script_arg_int32,0,
+    sim_script_arg_int32|sim_script_arg_table,0,
+    sim_script_arg_double|SIM_SCRIPT_ARG_NULL_ALLOWED,0,
+    sim_script_arg_int32|SIM_SCRIPT_ARG_NULL_ALLOWED,0,
+    sim_script_arg_double|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,4,
+    sim_script_arg_string|SIM_SCRIPT_ARG_NULL_ALLOWED,0,
+    sim_script_arg_int32|SIM_SCRIPT_ARG_NULL_ALLOWED,0,
+    sim_script_arg_int32|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,0,
+    sim_script_arg_double|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,0,
+    sim_script_arg_double|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,0,
+    sim_script_arg_bool|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // work on a pooled copy of the environment
+    sim_script_arg_int32|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // cb reference, instead of a cb func name
+};
+
+void LUA_GETCONFIGFORTIPPOSE_CALLBACK(SScriptCallBack* p)
+{
+    CScriptFunctionData D;
+    int calcResult=-1;
+    double* retConfig=nullptr;
+    size_t jointCnt=0;
+    if (D.readDataFromStack(p->stackID,inArgs_GETCONFIGFORTIPPOSE,inArgs_GETCONFIGFORTIPPOSE[0]-10,LUA_GETCONFIGFORTIPPOSE_COMMAND))
+    {
+        std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
+        int envId=inData->at(0).int32Data[0];
+        int ikGroupHandle=inData->at(1).int32Data[0];
+        std::string err;
+        {
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
+            {
+                jointCnt=inData->at(2).int32Data.size();
+                if (jointCnt>0)
+                {
+                    retConfig=new double[jointCnt];
+                    double thresholdDist=double(0.1);
+                    int iterations=1000;
+                    double* metric=nullptr;
+                    int* jointOptions=nullptr;
+                    double* lowLimits=nullptr;
+                    double* ranges=nullptr;
+                    bool(*cb)(double*)=nullptr;
+                    int scriptType=sim_scripttype_childscript;
+                    if ( (inData->size()>4)&&(inData->at(4).int32Data.size()==1) )
+                        iterations=inData->at(4).int32Data[0];
+                    if ( (inData->size()>8)&&(inData->at(8).int32Data.size()>=jointCnt) )
+                        jointOptions=&inData->at(8).int32Data[0];
+                    if ( (inData->size()>7)&&(inData->at(7).int32Data.size()==1) )
+                        scriptType=inData->at(7).int32Data[0];
+                    if ( (inData->size()>12)&&(inData->at(12).int32Data.size()==1) )
+                    {
+                        ctx.validationCallback.func.set(scriptType,inData->at(12).int32Data[0]);
+                        ctx.validationCallback.jointCnt=jointCnt;
+                        cb=validationCallback;
+                    }
+                    else if ( (inData->size()>6)&&(inData->at(6).stringData.size()==1)&&(inData->at(6).stringData[0].size()>0) )
+                    { // deprecated
+                        ctx.validationCallback.func.set(scriptType,inData->at(6).stringData[0]);
+                        ctx.validationCallback.jointCnt=jointCnt;
+                        cb=validationCallback;
+                    }
+                    if ( (inData->size()>3)&&(inData->at(3).doubleData.size()==1) )
+                        thresholdDist=inData->at(3).doubleData[0];
+                    if ( (inData->size()>5)&&(inData->at(5).doubleData.size()>=4) )
+                        metric=&inData->at(5).doubleData[0];
+                    if ( (inData->size()>9)&&(inData->at(9).doubleData.size()>=jointCnt) )
+                        lowLimits=&inData->at(9).doubleData[0];
+                    if ( (inData->size()>10)&&(inData->at(10).doubleData.size()>=jointCnt) )
+                        ranges=&inData->at(10).doubleData[0];
+                    bool onClone=( (inData->size()>11)&&(inData->at(11).boolData.size()==1)&&inData->at(11).boolData[0] );
+                    int cloneId=-1;
+                    if ( (!onClone)||_acquireEnvClone(envId,&cloneId) )
+                    {
+                        if (onClone)
+                            ctx.selectWorkEnvironment(cloneId);
+                        calcResult=ikGetConfigForTipPose(ikGroupHandle,jointCnt,&inData->at(2).int32Data[0],thresholdDist,iterations,retConfig,metric,cb,jointOptions,lowLimits,ranges);
+                        if (calcResult==-1)
+                             err=_getLastError();
+                        if (onClone)
+                        {
+                            _releaseEnvClone(envId,cloneId);
+                            ctx.selectWorkEnvironment(envId);
+                        }
+                    }
+                    else
+                        err=_getLastError();
+                }
+                else
+                    err="invalid joint handles";
+            }
+            else
+                 err=_getLastError();
+        }
+        if (err.size()>0)
+            simSetLastError(LUA_GETCONFIGFORTIPPOSE_COMMAND,err.c_str());
+    }
+    if (calcResult==1)
+    {
+        std::vector<double> v(retConfig,retConfig+jointCnt);
+        D.pushOutData(CScriptFunctionDataItem(v));
+        D.writeDataToStack(p->stackID);
+    }
+    if (retConfig!=nullptr)
+        delete[] retConfig;
+}
+// --------------------------------------------------------------------------------------
+
+static const double _twoPi=6.28318530717958647692;
+
+// --------------------------------------------------------------------------------------
+// simIK._findConfig
+// --------------------------------------------------------------------------------------
+#define LUA_FINDCONFIG_COMMAND_PLUGIN "simIK._findConfig@IK"
+#define LUA_FINDCONFIG_COMMAND "simIK._findConfig"
+
+const int inArgs_FINDCONFIG[]={
+    18,
+    sim_script_arg_int32,0,
+    sim_script_arg_int32,0,
+    sim_script_arg_int32|sim_script_arg_table,0,
+    sim_script_arg_double|SIM_SCRIPT_ARG_NULL_ALLOWED,0,
+    sim_script_arg_int32|SIM_SCRIPT_ARG_NULL_ALLOWED,0,
+    sim_script_arg_double|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,4,
+    sim_script_arg_int32|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // cb reference
+    sim_script_arg_int32|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // script handle of cb
+    sim_script_arg_int32|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // seed
+    sim_script_arg_int32|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // sampling strategy
+    sim_script_arg_bool|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // use the solution cache
+    sim_script_arg_int32|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // validation batch size
+    sim_script_arg_int32|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // native validator types
+    sim_script_arg_int32|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // native validator int parameters
+    sim_script_arg_double|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // native validator double parameters
+    sim_script_arg_int32|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // scene joints, for collision checks
+    sim_script_arg_int32|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // collision pairs
+    sim_script_arg_int32|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // number of independent starts
+};
+
+struct SSamplingStats
+{
+    double searches;
+    double successes;
+    double samplesToSuccess; // summed over successful searches
+    double samples;
+};
+
+static SSamplingStats _samplingStats[sampling_count]={}; // process-wide, for all scripts and environments. Protected by the interface lock
+
+struct SConfigSearch
+{
+    int ikGroupHandle;
+    size_t jointCnt;
+    int* jointHandles;
+    double thresholdDist;
+    double* metric;
+    bool(*cb)(double*);
+    double* retConfig;
+    size_t validationBatchSize; // when >1, candidates are validated in batches via validationCallbackBatch instead of cb
+    CConfigValidator* validator; // native checks, part of cb. Applied separately when validating in batches
+};
+
+static int _getElapsedMs(const std::chrono::steady_clock::time_point& startTime)
+{
+    return(int(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now()-startTime).count()));
+}
+
+static bool _getSamplingIntervals(const SConfigSearch& search,std::vector<double>& lows,std::vector<double>& ranges,std::string& err)
+{ // call with the environment context set
+    lows.resize(search.jointCnt);
+    ranges.resize(search.jointCnt);
+    for (size_t i=0;i<search.jointCnt;i++)
+    {
+        bool cyclic;
+        double interv[2];
+        if (!ikGetJointInterval(search.jointHandles[i],&cyclic,interv))
+        {
+            err=_getLastError();
+            return(false);
+        }
+        lows[i]=interv[0];
+        ranges[i]=interv[1];
+        if (cyclic)
+        {
+            lows[i]=-_twoPi*0.5;
+            ranges[i]=_twoPi;
+        }
+    }
+    return(true);
+}
+
+struct SConfigSearchStart
+{ // one independent start of a sampled search, with its own sampler and environment
+    CConfigSampler* sampler;
+    int envId; // the searched environment, or a pooled copy of it
+    std::vector<double> batch; // candidates waiting for batched validation
+};
+
+static int _searchConfigBlock(const SConfigSearch& search,SConfigSearchStart& start,const std::chrono::steady_clock::time_point& startTime,int timeInMs,size_t& sampleCnt)
+{ // call with start.envId selected. Tries one block of samples of the start. Each sample is handed over as a zero-range interval
+    static const size_t blockSize=16;
+    std::vector<double> samples(blockSize*search.jointCnt);
+    std::vector<double> zeroRanges(search.jointCnt,0.0);
+    start.sampler->getNext(&samples[0],blockSize);
+    int retVal=0;
+    if (search.validationBatchSize>1)
+    { // collect IK solutions without script validation, then validate them with one script call per batch
+        for (size_t j=0;(j<blockSize)&&(start.batch.size()<search.validationBatchSize*search.jointCnt);j++)
+        {
+            sampleCnt++;
+            int res=ikGetConfigForTipPose(search.ikGroupHandle,search.jointCnt,search.jointHandles,search.thresholdDist,1,search.retConfig,search.metric,nullptr,nullptr,&samples[j*search.jointCnt],&zeroRanges[0]);
+            if (res==-1)
+                return(-1);
+            if ( (res==1)&&( (search.validator==nullptr)||search.validator->isValid(search.retConfig) ) )
+                start.batch.insert(start.batch.end(),search.retConfig,search.retConfig+search.jointCnt);
+        }
+        // a full batch costs up to validationBatchSize-1 solves more than needed: once half of the time is
+        // used up, a non-empty batch is validated right away
+        bool timeShort=(2*_getElapsedMs(startTime)>=timeInMs);
+        if ( (start.batch.size()>0)&&(timeShort||(start.batch.size()>=search.validationBatchSize*search.jointCnt)) )
+        {
+            int valid=validationCallbackBatch(start.batch);
+            if ( (valid>=0)&&(size_t(valid)<start.batch.size()/search.jointCnt) )
+            {
+                for (size_t i=0;i<search.jointCnt;i++)
+                    search.retConfig[i]=start.batch[size_t(valid)*search.jointCnt+i];
+                retVal=1;
+            }
+            start.batch.clear();
+        }
+        return(retVal);
+    }
+    for (size_t j=0;(retVal==0)&&(j<blockSize);j++)
+    {
+        sampleCnt++;
+        retVal=ikGetConfigForTipPose(search.ikGroupHandle,search.jointCnt,search.jointHandles,search.thresholdDist,1,search.retConfig,search.metric,search.cb,nullptr,&samples[j*search.jointCnt],&zeroRanges[0]);
+    }
+    return(retVal);
+}
+
+static int _searchConfig(CEnvContext& ctx,const SConfigSearch& search,std::vector<SConfigSearchStart>& starts,int timeInMs,size_t& sampleCnt)
+{ // without starts, sampling is left to the kinematics routines. Otherwise the starts take turns, one block of
+  // samples each, and the time is checked once per round. The first valid configuration ends all starts.
+  // sampleCnt is the number of samples tried
+    sampleCnt=0;
+    if (starts.size()==0)
+        return(ikFindConfig(search.ikGroupHandle,search.jointCnt,search.jointHandles,search.thresholdDist,timeInMs,search.retConfig,search.metric,search.cb));
+    auto startTime=std::chrono::steady_clock::now();
+    int retVal=0;
+    do
+    {
+        for (size_t i=0;(retVal==0)&&(i<starts.size());i++)
+        {
+            if (ctx.selectWorkEnvironment(starts[i].envId))
+                retVal=_searchConfigBlock(search,starts[i],startTime,timeInMs,sampleCnt);
+            else
+                retVal=-1;
+        }
+    }
+    while ( (retVal==0)&&(_getElapsedMs(startTime)<timeInMs) );
+    ctx.selectWorkEnvironment(ctx.getEnvId());
+    return(retVal);
+}
+
+static bool _getTargetPoses(int ikGroupHandle,std::vector<double>& poses,std::string& err)
+{ // call with the environment context set. World poses of the targets of the IK group's elements, in object order
+    poses.clear();
+    int objectHandle;
+    std::string objectName;
+    bool isJoint;
+    int jointType;
+    for (size_t i=0;ikGetObjects(i,&objectHandle,&objectName,&isJoint,&jointType);i++)
+    {
+        int targetHandle=-1;
+        int elementFlags;
+        if ( (!isJoint)&&ikGetTargetDummy(objectHandle,&targetHandle)&&(targetHandle>=0)&&ikGetElementFlags(ikGroupHandle,objectHandle+ik_handleflag_tipdummy,&elementFlags) )
+        {
+            C7Vector tr;
+            if (!ikGetObjectTransformation(targetHandle,ik_handle_world,&tr))
+            {
+                err=_getLastError();
+                return(false);
+            }
+            poses.insert(poses.end(),{tr.X(0),tr.X(1),tr.X(2),tr.Q(0),tr.Q(1),tr.Q(2),tr.Q(3)});
+        }
+    }
+    return(true);
+}
+
+static bool _findConfigFromCache(int envId,const SConfigSearch& search,std::vector<double>& targetPoses,int& calcResult,std::string& err)
+{ // tries a local solve from the nearest cached configurations. Returns true on a hit
+    static const double defaultMetric[4]={1.0,1.0,1.0,0.1};
+    static const size_t maxSeeds=4;
+    if (!_getTargetPoses(search.ikGroupHandle,targetPoses,err))
+        return(false);
+    const double* metric=defaultMetric;
+    if (search.metric!=nullptr)
+        metric=search.metric;
+    std::vector<int> joints(search.jointHandles,search.jointHandles+search.jointCnt);
+    std::vector<std::vector<double>> seeds;
+    _configCache->getSeeds(envId,search.ikGroupHandle,targetPoses,joints,metric,search.thresholdDist,maxSeeds,seeds);
+    std::vector<double> zeroRanges(search.jointCnt,0.0);
+    bool batchedValidation=(search.validationBatchSize>1);
+    bool(*cb)(double*)=search.cb;
+    if (batchedValidation)
+        cb=nullptr;
+    calcResult=0;
+    for (size_t i=0;(calcResult==0)&&(i<seeds.size());i++)
+    {
+        calcResult=ikGetConfigForTipPose(search.ikGroupHandle,search.jointCnt,search.jointHandles,search.thresholdDist,1,search.retConfig,search.metric,cb,nullptr,&seeds[i][0],&zeroRanges[0]);
+        if ( batchedValidation&&(calcResult==1) )
+        {
+            if ( ( (search.validator!=nullptr)&&(!search.validator->isValid(search.retConfig)) )||(validationCallbackBatch(std::vector<double>(search.retConfig,search.retConfig+search.jointCnt))!=0) )
+                calcResult=0;
+        }
+    }
+    if (calcResult==-1)
+    {
+        err=_getLastError();
+        return(false);
+    }
+    _configCache->countLookup(envId,search.ikGroupHandle,calcResult==1);
+    return(calcResult==1);
+}
+
+void LUA_FINDCONFIG_CALLBACK(SScriptCallBack* p)
+{
+    CScriptFunctionData D;
+    int calcResult=-1;
+    double* retConfig=nullptr;
+    size_t jointCnt=0;
+    if (D.readDataFromStack(p->stackID,inArgs_FINDCONFIG,inArgs_FINDCONFIG[0]-15,LUA_FINDCONFIG_COMMAND))
+    {
+        std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
+        int envId=inData->at(0).int32Data[0];
+        int ikGroupHandle=inData->at(1).int32Data[0];
+        std::string err;
+        {
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
+            {
+                jointCnt=inData->at(2).int32Data.size();
+                if (jointCnt>0)
+                {
+                    retConfig=new double[jointCnt];
+                    double thresholdDist=double(0.1);
+                    int timeInMs=100;
+                    double* metric=nullptr;
+                    bool(*cb)(double*)=nullptr;
+                    int scriptType=sim_scripttype_childscript;
+                    if ( (inData->size()>4)&&(inData->at(4).int32Data.size()==1) )
+                        timeInMs=inData->at(4).int32Data[0];
+                    if ( (inData->size()>7)&&(inData->at(7).int32Data.size()==1) )
+                        scriptType=inData->at(7).int32Data[0];
+                    if ( (inData->size()>6)&&(inData->at(6).int32Data.size()==1) )
+                    {
+                        ctx.validationCallback.func.set(scriptType,inData->at(6).int32Data[0]);
+                        ctx.validationCallback.jointCnt=jointCnt;
+                        cb=validationCallback;
+                    }
+                    if ( (inData->size()>3)&&(inData->at(3).doubleData.size()==1) )
+                        thresholdDist=inData->at(3).doubleData[0];
+                    if ( (inData->size()>5)&&(inData->at(5).doubleData.size()>=4) )
+                        metric=&inData->at(5).doubleData[0];
+                    size_t validationBatchSize=1;
+                    if ( (cb!=nullptr)&&(inData->size()>11)&&(inData->at(11).int32Data.size()==1)&&(inData->at(11).int32Data[0]>1) )
+                        validationBatchSize=size_t(inData->at(11).int32Data[0]);
+                    CConfigValidator validator;
+                    if ( _setupNativeValidator(inData,12,inData->at(2).int32Data,validator,err)&&validator.hasValidators() )
+                    {
+                        ctx.validationCallback.nativeValidator=&validator;
+                        cb=nativeValidationCallback;
+                    }
+                    CConfigValidator* nativeValidator=nullptr;
+                    if (validator.hasValidators())
+                        nativeValidator=&validator;
+                    SConfigSearch search={ikGroupHandle,jointCnt,&inData->at(2).int32Data[0],thresholdDist,metric,cb,retConfig,validationBatchSize,nativeValidator};
+                    int startCnt=1;
+                    if ( (inData->size()>17)&&(inData->at(17).int32Data.size()==1) )
+                    {
+                        startCnt=inData->at(17).int32Data[0];
+                        if (startCnt<1)
+                            err="invalid number of starts";
+                    }
+                    std::vector<SConfigSearchStart> starts;
+                    bool hasSeed=( (inData->size()>8)&&(inData->at(8).int32Data.size()==1) );
+                    int strategy=sampling_random;
+                    bool hasStrategy=( (inData->size()>9)&&(inData->at(9).int32Data.size()==1) );
+                    if (hasStrategy)
+                    {
+                        strategy=inData->at(9).int32Data[0];
+                        if ( (strategy<0)||(strategy>=sampling_count) )
+                            err="invalid sampling strategy";
+                    }
+                    bool batchedValidation=(validationBatchSize>1); // needs samples drawn by the plugin
+                    if ( (err.size()==0)&&(hasSeed||hasStrategy||batchedValidation||(startCnt>1)) )
+                    {
+                        std::vector<double> lows;
+                        std::vector<double> ranges;
+                        if (_getSamplingIntervals(search,lows,ranges,err))
+                        {
+                            unsigned int seed=0;
+                            if (hasSeed)
+                                seed=(unsigned int)inData->at(8).int32Data[0];
+                            for (int i=0;i<startCnt;i++)
+                            { // with several starts, each start searches its own pooled copy of the environment
+                                SConfigSearchStart start;
+                                start.envId=envId;
+                                if ( (startCnt>1)&&((!ctx.selectWorkEnvironment(envId))||(!_acquireEnvClone(envId,&start.envId))) )
+                                {
+                                    err=_getLastError();
+                                    break;
+                                }
+                                if (!hasSeed)
+                                    seed=std::random_device()();
+                                start.sampler=new CConfigSampler(strategy,seed+(unsigned int)i,lows,ranges);
+                                starts.push_back(start);
+                            }
+                            ctx.selectWorkEnvironment(envId);
+                        }
+                    }
+                    bool useCache=( (inData->size()>10)&&(inData->at(10).boolData.size()==1)&&inData->at(10).boolData[0] );
+                    std::vector<double> targetPoses;
+                    if ( (err.size()==0)&&useCache )
+                        _findConfigFromCache(envId,search,targetPoses,calcResult,err);
+                    if ( (err.size()==0)&&(calcResult!=1) )
+                    {
+                        size_t sampleCnt;
+                        calcResult=_searchConfig(ctx,search,starts,timeInMs,sampleCnt);
+                        if (calcResult==-1)
+                             err=_getLastError();
+                        if (starts.size()>0)
+                        {
+                            SSamplingStats& stats=_samplingStats[strategy];
+                            double samples=double(sampleCnt);
+                            stats.searches+=1.0;
+                            stats.samples+=samples;
+                            if (calcResult==1)
+                            {
+                                stats.successes+=1.0;
+                                stats.samplesToSuccess+=samples;
+                            }
+                        }
+                        if ( useCache&&(calcResult==1) )
+                            _configCache->add(envId,ikGroupHandle,targetPoses,std::vector<int>(search.jointHandles,search.jointHandles+jointCnt),std::vector<double>(retConfig,retConfig+jointCnt));
+                    }
+                    for (size_t i=0;i<starts.size();i++)
+                    {
+                        if (starts[i].envId!=envId)
+                            _releaseEnvClone(envId,starts[i].envId);
+                        delete starts[i].sampler;
+                    }
+                    ctx.selectWorkEnvironment(envId);
+                }
+                else
+                    err="invalid joint handles";
+            }
+            else
+                 err=_getLastError();
+        }
+        if (err.size()>0)
+            simSetLastError(LUA_FINDCONFIG_COMMAND,err.c_str());
+    }
+    if (calcResult==1)
+    {
+        std::vector<double> v(retConfig,retConfig+jointCnt);
         D.pushOutData(CScriptFunctionDataItem(v));
         D.writeDataToStack(p->stackID);
     }
-    if (retConfig!=nullptr)
-        delete[] retConfig;
+    if (retConfig!=nullptr)
+        delete[] retConfig;
+}
+// --------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------
+// simIK._getConfigSearchStats
+// --------------------------------------------------------------------------------------
+#define LUA_GETCONFIGSEARCHSTATS_COMMAND_PLUGIN "simIK._getConfigSearchStats@IK"
+#define LUA_GETCONFIGSEARCHSTATS_COMMAND "simIK._getConfigSearchStats"
+
+const int inArgs_GETCONFIGSEARCHSTATS[]={
+    1,
+    sim_script_arg_bool,0,
+};
+
+void LUA_GETCONFIGSEARCHSTATS_CALLBACK(SScriptCallBack* p)
+{
+    CScriptFunctionData D;
+    if (D.readDataFromStack(p->stackID,inArgs_GETCONFIGSEARCHSTATS,inArgs_GETCONFIGSEARCHSTATS[0]-1,LUA_GETCONFIGSEARCHSTATS_COMMAND))
+    {
+        std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
+        bool reset=( (inData->size()>0)&&inData->at(0).boolData[0] );
+        std::vector<double> stats;
+        {
+            CLockInterface lock;
+            for (size_t i=0;i<sampling_count;i++)
+            {
+                stats.push_back(_samplingStats[i].searches);
+                stats.push_back(_samplingStats[i].successes);
+                stats.push_back(_samplingStats[i].samplesToSuccess);
+                stats.push_back(_samplingStats[i].samples);
+                if (reset)
+                    _samplingStats[i]=SSamplingStats();
+            }
+        }
+        D.pushOutData(CScriptFunctionDataItem(stats));
+        D.writeDataToStack(p->stackID);
+    }
+}
+// --------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------
+// simIK.getConfigCacheStats
+// --------------------------------------------------------------------------------------
+#define LUA_GETCONFIGCACHESTATS_COMMAND_PLUGIN "simIK.getConfigCacheStats@IK"
+#define LUA_GETCONFIGCACHESTATS_COMMAND "simIK.getConfigCacheStats"
+
+const int inArgs_GETCONFIGCACHESTATS[]={
+    3,
+    sim_script_arg_int32,0,
+    sim_script_arg_int32,0,
+    sim_script_arg_bool,0,
+};
+
+void LUA_GETCONFIGCACHESTATS_CALLBACK(SScriptCallBack* p)
+{
+    CScriptFunctionData D;
+    if (D.readDataFromStack(p->stackID,inArgs_GETCONFIGCACHESTATS,inArgs_GETCONFIGCACHESTATS[0]-1,LUA_GETCONFIGCACHESTATS_COMMAND))
+    {
+        std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
+        int envId=inData->at(0).int32Data[0];
+        int ikGroupHandle=inData->at(1).int32Data[0];
+        bool clear=( (inData->size()>2)&&inData->at(2).boolData[0] );
+        size_t hits,misses,entries;
+        {
+            CLockInterface lock;
+            _configCache->getStats(envId,ikGroupHandle,hits,misses,entries);
+            if (clear)
+                _configCache->clear(envId,ikGroupHandle);
+        }
+        D.pushOutData(CScriptFunctionDataItem(int(hits)));
+        D.pushOutData(CScriptFunctionDataItem(int(misses)));
+        D.pushOutData(CScriptFunctionDataItem(int(entries)));
+        D.writeDataToStack(p->stackID);
+    }
+}
+// --------------------------------------------------------------------------------------
+
+bool _getAlternateConfigIntervals(const std::vector<int>& jointHandles,const double* lowLimits,const double* ranges,std::vector<double>& lows,std::vector<double>& highs,bool& noSolution,std::string& err)
+{ // call with the environment context set. For each joint, the 2*pi-shifted positions to visit are lows[i], lows[i]+2*pi, .. <=highs[i]
+    noSolution=false;
+    lows.resize(jointHandles.size());
+    highs.resize(jointHandles.size());
+    for (size_t i=0;i<jointHandles.size();i++)
+    {
+        double pos;
+        bool cyclic;
+        double interv[2];
+        int jointType;
+        double lead;
+        if ( (!ikGetJointPosition(jointHandles[i],&pos))||(!ikGetJointInterval(jointHandles[i],&cyclic,interv))||(!ikGetJointType(jointHandles[i],&jointType))||(!ikGetJointScrewLead(jointHandles[i],&lead)) )
+        {
+            err=_getLastError();
+            return(false);
+        }
+        lows[i]=pos;
+        highs[i]=pos;
+        if ( (jointType==ik_jointtype_revolute)&&(!cyclic)&&(lead==0.0) )
+        {
+            if ( (pos-_twoPi>=interv[0])||(pos+_twoPi<=interv[0]+interv[1]) )
+            { // We use the low and range values from the joint's settings
+                double y=pos;
+                while (y-_twoPi>=interv[0])
+                    y-=_twoPi;
+                lows[i]=y;
+                highs[i]=interv[0]+interv[1];
+                if ( (lowLimits!=nullptr)&&(ranges!=nullptr)&&(ranges[i]!=0.0) )
+                { // the user specified low and range values. Use those instead:
+                    double l=lowLimits[i];
+                    double r=ranges[i];
+                    if (r>0.0)
+                    {
+                        if (l<interv[0])
+                        { // correct for user bad input
+                            r-=interv[0]-l;
+                            l=interv[0];
+                        }
+                        if (l>interv[0]+interv[1])
+                        { // bad user input. No alternative position for this joint
+                            lows[i]=pos;
+                            highs[i]=pos;
+                            noSolution=true;
+                        }
+                        else
+                        {
+                            if (l+r>interv[0]+interv[1])
+                                r=interv[0]+interv[1]-l; // correct for user bad input
+                            if ( (pos-_twoPi>=l)||(pos+_twoPi<=l+r) )
+                            {
+                                y=pos;
+                                while (y<l)
+                                    y+=_twoPi;
+                                while (y-_twoPi>=l)
+                                    y-=_twoPi;
+                                lows[i]=y;
+                                highs[i]=l+r;
+                            }
+                            else
+                            { // no alternative position for this joint
+                                lows[i]=pos;
+                                highs[i]=pos;
+                                if ( (pos<l)||(pos>l+r) )
+                                    noSolution=true;
+                            }
+                        }
+                    }
+                    else
+                    { // range centered on the current position
+                        r=-r;
+                        l=std::max<double>(pos-r*0.5,lows[i]);
+                        double u=std::min<double>(pos+r*0.5,highs[i]);
+                        y=pos;
+                        while (y-_twoPi>=l)
+                            y-=_twoPi;
+                        lows[i]=y;
+                        highs[i]=u;
+                    }
+                }
+            }
+        }
+    }
+    return(true);
+}
+
+bool _getNextAlternateConfig(std::vector<double>& config,const std::vector<double>& lows,const std::vector<double>& highs)
+{ // odometer-like: the last joint turns fastest. Returns false once all combinations were visited
+    for (size_t j=config.size();j>0;j--)
+    {
+        size_t i=j-1;
+        config[i]+=_twoPi;
+        if (config[i]<=highs[i])
+            return(true);
+        config[i]=lows[i];
+    }
+    return(false);
+}
+
+// --------------------------------------------------------------------------------------
+// simIK.getAlternateConfigs
+// --------------------------------------------------------------------------------------
+#define LUA_GETALTERNATECONFIGS_COMMAND_PLUGIN "simIK.getAlternateConfigs@IK"
+#define LUA_GETALTERNATECONFIGS_COMMAND "simIK.getAlternateConfigs"
+
+const int inArgs_GETALTERNATECONFIGS[]={
+    4,
+    sim_script_arg_int32,0,
+    sim_script_arg_int32|sim_script_arg_table,1,
+    sim_script_arg_double|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,1,
+    sim_script_arg_double|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,1,
+};
+
+void LUA_GETALTERNATECONFIGS_CALLBACK(SScriptCallBack* p)
+{
+    CScriptFunctionData D;
+    std::vector<double> configs;
+    bool result=false;
+    if (D.readDataFromStack(p->stackID,inArgs_GETALTERNATECONFIGS,inArgs_GETALTERNATECONFIGS[0]-2,LUA_GETALTERNATECONFIGS_COMMAND))
+    {
+        std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
+        int envId=inData->at(0).int32Data[0];
+        const std::vector<int>& jointHandles=inData->at(1).int32Data;
+        size_t dof=jointHandles.size();
+        double* lowLimits=nullptr;
+        double* ranges=nullptr;
+        std::string err;
+        if ( (inData->size()>2)&&(inData->at(2).doubleData.size()>0) )
+            lowLimits=&inData->at(2).doubleData[0];
+        if ( (inData->size()>3)&&(inData->at(3).doubleData.size()>0) )
+            ranges=&inData->at(3).doubleData[0];
+        if ( ( (lowLimits==nullptr)||(inData->at(2).doubleData.size()==dof) )&&( (ranges==nullptr)||(inData->at(3).doubleData.size()==dof) ) )
+        {
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
+            {
+                std::vector<double> lows;
+                std::vector<double> highs;
+                bool noSolution;
+                result=_getAlternateConfigIntervals(jointHandles,lowLimits,ranges,lows,highs,noSolution,err);
+                if ( result&&(!noSolution) )
+                {
+                    size_t cnt=1;
+                    for (size_t i=0;i<dof;i++)
+                        cnt*=size_t((highs[i]-lows[i])/_twoPi)+1;
+                    configs.reserve(cnt*dof);
+                    std::vector<double> config(lows);
+                    do
+                        configs.insert(configs.end(),config.begin(),config.end());
+                    while (_getNextAlternateConfig(config,lows,highs));
+                }
+            }
+            else
+                err=_getLastError();
+        }
+        else
+            err="bad table size";
+        if (err.size()>0)
+            simSetLastError(LUA_GETALTERNATECONFIGS_COMMAND,err.c_str());
+    }
+    if (result)
+    {
+        D.pushOutData(CScriptFunctionDataItem(configs));
+        D.writeDataToStack(p->stackID);
+    }
+}
+// --------------------------------------------------------------------------------------
+
+struct SAltConfigIterator
+{
+    int scriptHandle;
+    std::vector<double> lows;
+    std::vector<double> highs;
+    std::vector<double> config; // next configuration to return
+    bool exhausted;
+};
+
+static std::map<int,SAltConfigIterator> altConfigIterators; // access only with the interface locked
+static int nextAltConfigIteratorHandle=0;
+
+// --------------------------------------------------------------------------------------
+// simIK.createAltConfigIterator
+// --------------------------------------------------------------------------------------
+#define LUA_CREATEALTCONFIGITERATOR_COMMAND_PLUGIN "simIK.createAltConfigIterator@IK"
+#define LUA_CREATEALTCONFIGITERATOR_COMMAND "simIK.createAltConfigIterator"
+
+const int inArgs_CREATEALTCONFIGITERATOR[]={
+    4,
+    sim_script_arg_int32,0,
+    sim_script_arg_int32|sim_script_arg_table,1,
+    sim_script_arg_double|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,1,
+    sim_script_arg_double|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,1,
+};
+
+void LUA_CREATEALTCONFIGITERATOR_CALLBACK(SScriptCallBack* p)
+{
+    CScriptFunctionData D;
+    int retVal=-1;
+    if (D.readDataFromStack(p->stackID,inArgs_CREATEALTCONFIGITERATOR,inArgs_CREATEALTCONFIGITERATOR[0]-2,LUA_CREATEALTCONFIGITERATOR_COMMAND))
+    {
+        std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
+        int envId=inData->at(0).int32Data[0];
+        const std::vector<int>& jointHandles=inData->at(1).int32Data;
+        size_t dof=jointHandles.size();
+        double* lowLimits=nullptr;
+        double* ranges=nullptr;
+        std::string err;
+        if ( (inData->size()>2)&&(inData->at(2).doubleData.size()>0) )
+            lowLimits=&inData->at(2).doubleData[0];
+        if ( (inData->size()>3)&&(inData->at(3).doubleData.size()>0) )
+            ranges=&inData->at(3).doubleData[0];
+        if ( ( (lowLimits==nullptr)||(inData->at(2).doubleData.size()==dof) )&&( (ranges==nullptr)||(inData->at(3).doubleData.size()==dof) ) )
+        {
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
+            {
+                SAltConfigIterator it;
+                bool noSolution;
+                if (_getAlternateConfigIntervals(jointHandles,lowLimits,ranges,it.lows,it.highs,noSolution,err))
+                {
+                    it.scriptHandle=p->scriptID;
+                    it.config=it.lows;
+                    it.exhausted=noSolution;
+                    retVal=nextAltConfigIteratorHandle++;
+                    altConfigIterators[retVal]=it;
+                }
+            }
+            else
+                err=_getLastError();
+        }
+        else
+            err="bad table size";
+        if (err.size()>0)
+            simSetLastError(LUA_CREATEALTCONFIGITERATOR_COMMAND,err.c_str());
+    }
+    if (retVal>=0)
+    {
+        D.pushOutData(CScriptFunctionDataItem(retVal));
+        D.writeDataToStack(p->stackID);
+    }
+}
+// --------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------
+// simIK.getNextAltConfigs
+// --------------------------------------------------------------------------------------
+#define LUA_GETNEXTALTCONFIGS_COMMAND_PLUGIN "simIK.getNextAltConfigs@IK"
+#define LUA_GETNEXTALTCONFIGS_COMMAND "simIK.getNextAltConfigs"
+
+const int inArgs_GETNEXTALTCONFIGS[]={
+    2,
+    sim_script_arg_int32,0,
+    sim_script_arg_int32,0,
+};
+
+void LUA_GETNEXTALTCONFIGS_CALLBACK(SScriptCallBack* p)
+{
+    CScriptFunctionData D;
+    std::vector<double> configs;
+    bool result=false;
+    if (D.readDataFromStack(p->stackID,inArgs_GETNEXTALTCONFIGS,inArgs_GETNEXTALTCONFIGS[0]-1,LUA_GETNEXTALTCONFIGS_COMMAND))
+    {
+        std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
+        int iteratorHandle=inData->at(0).int32Data[0];
+        int batchSize=1;
+        if ( (inData->size()>1)&&(inData->at(1).int32Data.size()==1) )
+            batchSize=inData->at(1).int32Data[0];
+        std::string err;
+        {
+            CLockInterface lock;
+            auto it=altConfigIterators.find(iteratorHandle);
+            if (it!=altConfigIterators.end())
+            {
+                SAltConfigIterator& iterator=it->second;
+                configs.reserve(size_t(std::max<int>(batchSize,0))*iterator.config.size());
+                for (int i=0;(i<batchSize)&&(!iterator.exhausted);i++)
+                {
+                    configs.insert(configs.end(),iterator.config.begin(),iterator.config.end());
+                    iterator.exhausted=!_getNextAlternateConfig(iterator.config,iterator.lows,iterator.highs);
+                }
+                result=true;
+            }
+            else
+                err="invalid iterator handle";
+        }
+        if (err.size()>0)
+            simSetLastError(LUA_GETNEXTALTCONFIGS_COMMAND,err.c_str());
+    }
+    if (result)
+    {
+        D.pushOutData(CScriptFunctionDataItem(configs));
+        D.writeDataToStack(p->stackID);
+    }
+}
+// --------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------
+// simIK.eraseAltConfigIterator
+// --------------------------------------------------------------------------------------
+#define LUA_ERASEALTCONFIGITERATOR_COMMAND_PLUGIN "simIK.eraseAltConfigIterator@IK"
+#define LUA_ERASEALTCONFIGITERATOR_COMMAND "simIK.eraseAltConfigIterator"
+
+const int inArgs_ERASEALTCONFIGITERATOR[]={
+    1,
+    sim_script_arg_int32,0,
+};
+
+void LUA_ERASEALTCONFIGITERATOR_CALLBACK(SScriptCallBack* p)
+{
+    CScriptFunctionData D;
+    if (D.readDataFromStack(p->stackID,inArgs_ERASEALTCONFIGITERATOR,inArgs_ERASEALTCONFIGITERATOR[0],LUA_ERASEALTCONFIGITERATOR_COMMAND))
+    {
+        std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
+        int iteratorHandle=inData->at(0).int32Data[0];
+        std::string err;
+        {
+            CLockInterface lock;
+            if (altConfigIterators.erase(iteratorHandle)==0)
+                err="invalid iterator handle";
+        }
+        if (err.size()>0)
+            simSetLastError(LUA_ERASEALTCONFIGITERATOR_COMMAND,err.c_str());
+    }
+}
+// --------------------------------------------------------------------------------------
+
+struct SEnvState
+{
+    int scriptHandle;
+    std::vector<SEnvStateObject> objects;
+    std::vector<double> state;
+};
+
+static std::map<int,SEnvState> envStates; // access only with the interface locked
+static int nextEnvStateHandle=0;
+
+// --------------------------------------------------------------------------------------
+// simIK.saveState
+// --------------------------------------------------------------------------------------
+#define LUA_SAVESTATE_COMMAND_PLUGIN "simIK.saveState@IK"
+#define LUA_SAVESTATE_COMMAND "simIK.saveState"
+
+const int inArgs_SAVESTATE[]={
+    2,
+    sim_script_arg_int32,0,
+    sim_script_arg_int32|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // objects, default is all objects
+};
+
+void LUA_SAVESTATE_CALLBACK(SScriptCallBack* p)
+{
+    CScriptFunctionData D;
+    int retVal=-1;
+    if (D.readDataFromStack(p->stackID,inArgs_SAVESTATE,inArgs_SAVESTATE[0]-1,LUA_SAVESTATE_COMMAND))
+    {
+        std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
+        int envId=inData->at(0).int32Data[0];
+        std::string err;
+        {
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
+            {
+                SEnvState st;
+                st.scriptHandle=p->scriptID;
+                bool ok=true;
+                if ( (inData->size()>1)&&(inData->at(1).int32Data.size()>0) )
+                {
+                    const std::vector<int>& handles=inData->at(1).int32Data;
+                    for (size_t i=0;ok&&(i<handles.size());i++)
+                    {
+                        SEnvStateObject obj={handles[i],false,-1};
+                        int objectType;
+                        ok=ikGetObjectType(obj.handle,&objectType);
+                        obj.isJoint=(objectType==ik_objecttype_joint);
+                        if ( ok&&obj.isJoint )
+                            ok=ikGetJointType(obj.handle,&obj.jointType);
+                        st.objects.push_back(obj);
+                    }
+                }
+                else
+                {
+                    const std::vector<SEnvStateObject>* objects=_envPool->getObjects(envId);
+                    if (objects!=nullptr)
+                        st.objects.assign(objects->begin(),objects->end());
+                    else
+                        _getEnvStateObjects(st.objects);
+                }
+                if ( ok&&_getEnvState(st.objects,st.state) )
+                {
+                    retVal=nextEnvStateHandle++;
+                    envStates[retVal]=std::move(st);
+                }
+                else
+                    err=_getLastError();
+            }
+            else
+                err=_getLastError();
+        }
+        if (err.size()>0)
+            simSetLastError(LUA_SAVESTATE_COMMAND,err.c_str());
+    }
+    if (retVal>=0)
+    {
+        D.pushOutData(CScriptFunctionDataItem(retVal));
+        D.writeDataToStack(p->stackID);
+    }
+}
+// --------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------
+// simIK.restoreState
+// --------------------------------------------------------------------------------------
+#define LUA_RESTORESTATE_COMMAND_PLUGIN "simIK.restoreState@IK"
+#define LUA_RESTORESTATE_COMMAND "simIK.restoreState"
+
+const int inArgs_RESTORESTATE[]={
+    2,
+    sim_script_arg_int32,0,
+    sim_script_arg_int32,0,
+};
+
+void LUA_RESTORESTATE_CALLBACK(SScriptCallBack* p)
+{
+    CScriptFunctionData D;
+    if (D.readDataFromStack(p->stackID,inArgs_RESTORESTATE,inArgs_RESTORESTATE[0],LUA_RESTORESTATE_COMMAND))
+    {
+        std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
+        int envId=inData->at(0).int32Data[0];
+        int stateHandle=inData->at(1).int32Data[0];
+        std::string err;
+        {
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
+            {
+                auto it=envStates.find(stateHandle);
+                if ( (it==envStates.end())||(it->second.scriptHandle!=p->scriptID) )
+                    err="invalid state handle";
+                else if (!_isEnvStateCompatible(it->second.objects))
+                    err="state does not match the environment";
+                else
+                {
+                    _allSyncGroups->invalidateTargets(envId); // target poses might change
+                    if (!_setEnvState(it->second.objects,it->second.state))
+                        err=_getLastError();
+                }
+            }
+            else
+                err=_getLastError();
+        }
+        if (err.size()>0)
+            simSetLastError(LUA_RESTORESTATE_COMMAND,err.c_str());
+    }
 }
 // --------------------------------------------------------------------------------------
 
 // --------------------------------------------------------------------------------------
-// simIK._findConfig
+// simIK.eraseState
 // --------------------------------------------------------------------------------------
-#define LUA_FINDCONFIG_COMMAND_PLUGIN "simIK._findConfig@IK"
-#define LUA_FINDCONFIG_COMMAND "simIK._findConfig"
+#define LUA_ERASESTATE_COMMAND_PLUGIN "simIK.eraseState@IK"
+#define LUA_ERASESTATE_COMMAND "simIK.eraseState"
 
-const int inArgs_FINDCONFIG[]={
-    8,
+const int inArgs_ERASESTATE[]={
+    1,
+    sim_script_arg_int32,0,
+};
+
+void LUA_ERASESTATE_CALLBACK(SScriptCallBack* p)
+{
+    CScriptFunctionData D;
+    if (D.readDataFromStack(p->stackID,inArgs_ERASESTATE,inArgs_ERASESTATE[0],LUA_ERASESTATE_COMMAND))
+    {
+        std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
+        int stateHandle=inData->at(0).int32Data[0];
+        std::string err;
+        {
+            CLockInterface lock;
+            auto it=envStates.find(stateHandle);
+            if ( (it==envStates.end())||(it->second.scriptHandle!=p->scriptID) )
+                err="invalid state handle";
+            else
+                envStates.erase(it);
+        }
+        if (err.size()>0)
+            simSetLastError(LUA_ERASESTATE_COMMAND,err.c_str());
+    }
+}
+// --------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------
+// simIK._generatePath
+// --------------------------------------------------------------------------------------
+#define LUA_GENERATEPATH_COMMAND_PLUGIN "simIK._generatePath@IK"
+#define LUA_GENERATEPATH_COMMAND "simIK._generatePath"
+
+const int inArgs_GENERATEPATH[]={
+    12,
     sim_script_arg_int32,0,
     sim_script_arg_int32,0,
-    sim_script_arg_int32|sim_script_arg_table,0,
-    sim_script_arg_double|SIM_SCRIPT_ARG_NULL_ALLOWED,0,
-    sim_script_arg_int32|SIM_SCRIPT_ARG_NULL_ALLOWED,0,
-    sim_script_arg_double|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,4,
-    sim_script_arg_string|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // cb func name
-    sim_script_arg_int32|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // script handle of cb
+    sim_script_arg_int32|sim_script_arg_table,1,
+    sim_script_arg_int32,0,
+    sim_script_arg_int32,0,
+    sim_script_arg_int32|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // native validator types
+    sim_script_arg_int32|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // native validator int parameters
+    sim_script_arg_double|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // native validator double parameters
+    sim_script_arg_int32|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // scene joints, for collision checks
+    sim_script_arg_int32|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // collision pairs
+    sim_script_arg_int32|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // validation cb reference
+    sim_script_arg_int32|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // script handle of validation cb
 };
 
-void LUA_FINDCONFIG_CALLBACK(SScriptCallBack* p)
+static bool _generatePath(int ikGroupHandle,const std::vector<int>& jointHandles,int tipHandle,int ptCnt,CConfigValidator* validator,std::vector<double>& path,std::string& err)
+{ // operates on the current environment, which is modified. Returns an empty path if a point could not be reached or is not valid.
+  // Each point is validated as soon as it is computed: natively first, then by the script callback of the context, if any
+    CEnvContext* ctx=CEnvContext::current();
+    size_t dof=jointHandles.size();
+    path.resize(size_t(ptCnt)*dof);
+    int targetHandle;
+    C7Vector startTr;
+    C7Vector goalTr;
+    if ( (!ikGetTargetDummy(tipHandle,&targetHandle))||(!ikGetObjectTransformation(tipHandle,ik_handle_world,&startTr))||(!ikGetObjectTransformation(targetHandle,ik_handle_world,&goalTr)) )
+    {
+        err=_getLastError();
+        return(false);
+    }
+    std::vector<int> groups(1,ikGroupHandle);
+    for (int j=0;j<ptCnt;j++)
+    {
+        if (j>0)
+        {
+            C7Vector tr;
+            tr.buildInterpolation(startTr,goalTr,double(j)/double(ptCnt-1));
+            int ikRes=ik_result_not_performed;
+            if ( (!ikSetObjectTransformation(targetHandle,ik_handle_world,&tr))||(!ikHandleGroups(&groups,&ikRes,nullptr)) )
+            {
+                err=_getLastError();
+                return(false);
+            }
+            if (_getResultFromCalcFlags(ikRes)!=1)
+            {
+                path.clear();
+                return(true);
+            }
+        }
+        for (size_t i=0;i<dof;i++)
+        {
+            if (!ikGetJointPosition(jointHandles[i],&path[size_t(j)*dof+i]))
+            {
+                err=_getLastError();
+                return(false);
+            }
+        }
+        if ( ( (validator!=nullptr)&&(!validator->isValid(&path[size_t(j)*dof])) )||( ctx->validationCallback.func.isSet()&&(!validationCallback(&path[size_t(j)*dof])) ) )
+        {
+            path.clear();
+            return(true);
+        }
+    }
+    return(true);
+}
+
+void LUA_GENERATEPATH_CALLBACK(SScriptCallBack* p)
 {
     CScriptFunctionData D;
-    int calcResult=-1;
-    double* retConfig=nullptr;
-    size_t jointCnt=0;
-    if (D.readDataFromStack(p->stackID,inArgs_FINDCONFIG,inArgs_FINDCONFIG[0]-5,LUA_FINDCONFIG_COMMAND))
+    std::vector<double> path;
+    bool result=false;
+    if (D.readDataFromStack(p->stackID,inArgs_GENERATEPATH,inArgs_GENERATEPATH[0]-7,LUA_GENERATEPATH_COMMAND))
     {
         std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
         int envId=inData->at(0).int32Data[0];
         int ikGroupHandle=inData->at(1).int32Data[0];
+        const std::vector<int>& jointHandles=inData->at(2).int32Data;
+        int tipHandle=inData->at(3).int32Data[0];
+        int ptCnt=inData->at(4).int32Data[0];
         std::string err;
+        if (ptCnt<1)
+            err="invalid point count";
+        if (err.size()==0)
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
-            {
-                jointCnt=inData->at(2).int32Data.size();
-                if (jointCnt>0)
+            CEnvContext ctx(envId);
+            CConfigValidator validator;
+            CConfigValidator* nativeValidator=nullptr;
+            if (!ctx.isValid())
+                err=_getLastError();
+            else if (_setupNativeValidator(inData,5,jointHandles,validator,err))
+            { // work on a private copy, so that the original environment remains unchanged
+                if (validator.hasValidators())
+                    nativeValidator=&validator;
+                if ( (inData->size()>11)&&(inData->at(10).int32Data.size()==1)&&(inData->at(11).int32Data.size()==1) )
                 {
-                    retConfig=new double[jointCnt];
-                    double thresholdDist=double(0.1);
-                    int timeInMs=100;
-                    double* metric=nullptr;
-                    bool(*cb)(double*)=nullptr;
-                    int scriptType=sim_scripttype_childscript;
-                    if ( (inData->size()>4)&&(inData->at(4).int32Data.size()==1) )
-                        timeInMs=inData->at(4).int32Data[0];
-                    if ( (inData->size()>7)&&(inData->at(7).int32Data.size()==1) )
-                        scriptType=inData->at(7).int32Data[0];
-                    if ( (inData->size()>6)&&(inData->at(6).stringData.size()==1)&&(inData->at(6).stringData[0].size()>0) )
-                    {
-                        validationCallback_funcNameAtScriptName=inData->at(6).stringData[0];
-                        validationCallback_scriptType=scriptType;
-                        validationCallback_jointCnt=jointCnt;
-                        validationCallback_envId=envId;
-                        cb=validationCallback;
-                    }
-                    if ( (inData->size()>3)&&(inData->at(3).doubleData.size()==1) )
-                        thresholdDist=inData->at(3).doubleData[0];
-                    if ( (inData->size()>5)&&(inData->at(5).doubleData.size()>=4) )
-                        metric=&inData->at(5).doubleData[0];
-                    calcResult=ikFindConfig(ikGroupHandle,jointCnt,&inData->at(2).int32Data[0],thresholdDist,timeInMs,retConfig,metric,cb);
-                    if (calcResult==-1)
-                         err=ikGetLastError();
+                    ctx.validationCallback.func.set(inData->at(11).int32Data[0],inData->at(10).int32Data[0]);
+                    ctx.validationCallback.jointCnt=jointHandles.size();
+                }
+                int dupEnvId;
+                if (_acquireEnvClone(envId,&dupEnvId))
+                {
+                    ctx.selectWorkEnvironment(dupEnvId); // script callbacks return to the copy
+                    result=_generatePath(ikGroupHandle,jointHandles,tipHandle,ptCnt,nativeValidator,path,err);
+                    ctx.selectWorkEnvironment(envId);
+                    _releaseEnvClone(envId,dupEnvId);
                 }
                 else
-                    err="invalid joint handles";
+                    err=_getLastError();
             }
-            else
-                 err=ikGetLastError();
         }
         if (err.size()>0)
-            simSetLastError(LUA_FINDCONFIG_COMMAND,err.c_str());
+            simSetLastError(LUA_GENERATEPATH_COMMAND,err.c_str());
     }
-    if (calcResult==1)
+    if (result)
     {
-        std::vector<double> v(retConfig,retConfig+jointCnt);
-        D.pushOutData(CScriptFunctionDataItem(v));
+        D.pushOutData(CScriptFunctionDataItem(path));
+        D.writeDataToStack(p->stackID);
+    }
+}
+// --------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------
+// simIK._solvePath
+// --------------------------------------------------------------------------------------
+#define LUA_SOLVEPATH_COMMAND_PLUGIN "simIK._solvePath@IK"
+#define LUA_SOLVEPATH_COMMAND "simIK._solvePath"
+
+const int inArgs_SOLVEPATH[]={
+    9,
+    sim_script_arg_int32,0,
+    sim_script_arg_int32,0,
+    sim_script_arg_int32,0,
+    sim_script_arg_int32|sim_script_arg_table,1,
+    sim_script_arg_int32,0,
+    sim_script_arg_double|sim_script_arg_table,7, // path poses (x y z qx qy qz qw)
+    sim_script_arg_double|sim_script_arg_table,4, // delta, minDelta, maxDelta, maxJointStep (0: no joint jump check)
+    sim_script_arg_int32|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // scene joints, for collision checks
+    sim_script_arg_int32|sim_script_arg_table|SIM_SCRIPT_ARG_NULL_ALLOWED,0, // collision pairs
+};
+
+static C7Vector _getPathInterpolatedPose(const std::vector<double>& pathData,const std::vector<double>& pathLengths,double posAlongPath)
+{ // linear interpolation for the position, slerp for the orientation
+    size_t i=0;
+    while ( (i+2<pathLengths.size())&&(pathLengths[i+1]<posAlongPath) )
+        i++;
+    const double* p0=&pathData[7*i];
+    C7Vector tr0(C4Vector(p0[6],p0[3],p0[4],p0[5]),C3Vector(p0));
+    if (pathLengths.size()<2)
+        return(tr0);
+    const double* p1=&pathData[7*(i+1)];
+    C7Vector tr1(C4Vector(p1[6],p1[3],p1[4],p1[5]),C3Vector(p1));
+    double segLength=pathLengths[i+1]-pathLengths[i];
+    double t=1.0;
+    if (segLength>0.0)
+        t=std::min<double>(1.0,std::max<double>(0.0,(posAlongPath-pathLengths[i])/segLength));
+    C7Vector tr;
+    tr.buildInterpolation(tr0,tr1,t);
+    return(tr);
+}
+
+static double _getJointStep(int jointHandle,double from,double to)
+{
+    double d=to-from;
+    bool cyclic;
+    double interv[2];
+    if ( ikGetJointInterval(jointHandle,&cyclic,interv)&&cyclic )
+        d=atan2(sin(d),cos(d));
+    return(fabs(d));
+}
+
+static bool _followPath(int ikGroupHandle,int ikTargetHandle,const std::vector<int>& jointHandles,int ikPathHandle,const std::vector<double>& pathData,const double params[4],CConfigValidator* validator,std::vector<double>& configs,std::vector<double>& positions,int& failure,int& failureCode,double& failPos,std::string& err)
+{ // operates on the current environment. Steps are bisected down to minDelta when IK fails or a joint jumps, and grow again up to
+  // maxDelta while joint motion stays small. A maxJointStep of 0 disables the joint jump check. With minDelta=maxDelta=delta,
+  // the path is followed with a fixed step
+    double minDelta=params[1];
+    double maxDelta=std::max<double>(params[2],minDelta);
+    double maxJointStep=params[3];
+    bool checkJointStep=(maxJointStep>0.0);
+    double delta=std::min<double>(maxDelta,std::max<double>(params[0],minDelta));
+    size_t dof=jointHandles.size();
+    size_t ptCnt=pathData.size()/7;
+    std::vector<double> pathLengths(ptCnt,0.0);
+    for (size_t i=1;i<ptCnt;i++)
+    {
+        C3Vector d(C3Vector(&pathData[7*i])-C3Vector(&pathData[7*(i-1)]));
+        pathLengths[i]=pathLengths[i-1]+d.getLength();
+    }
+    double totalLength=pathLengths[ptCnt-1];
+    std::vector<int> groups(1,ikGroupHandle);
+    std::vector<double> prevConfig(dof);
+    std::vector<double> config(dof);
+    for (size_t i=0;i<dof;i++)
+    {
+        if (!ikGetJointPosition(jointHandles[i],&prevConfig[i]))
+        {
+            err=_getLastError();
+            return(false);
+        }
+    }
+    failure=0;
+    failureCode=0;
+    failPos=-1.0;
+    double posAlongPath=0.0;
+    bool first=true;
+    while (true)
+    {
+        C7Vector pose(_getPathInterpolatedPose(pathData,pathLengths,posAlongPath));
+        if (ikPathHandle!=-1)
+        { // re-fetch path pose, should path be part of the IK chain
+            C7Vector pathPose;
+            if (!ikGetObjectTransformation(ikPathHandle,ik_handle_world,&pathPose))
+            {
+                err=_getLastError();
+                return(false);
+            }
+            pose=pathPose*pose;
+        }
+        int ikRes=ik_result_not_performed;
+        if ( (!ikSetObjectTransformation(ikTargetHandle,ik_handle_world,&pose))||(!ikHandleGroups(&groups,&ikRes,nullptr)) )
+        {
+            err=_getLastError();
+            return(false);
+        }
+        bool success=(_getResultFromCalcFlags(ikRes)==1);
+        double jointStep=0.0;
+        for (size_t i=0;success&&(i<dof);i++)
+        {
+            if (!ikGetJointPosition(jointHandles[i],&config[i]))
+            {
+                err=_getLastError();
+                return(false);
+            }
+            if (!first)
+                jointStep=std::max<double>(jointStep,_getJointStep(jointHandles[i],prevConfig[i],config[i]));
+        }
+        if ( (!success)||(checkJointStep&&(jointStep>maxJointStep)) )
+        {
+            double prevPos=0.0;
+            if (positions.size()>0)
+                prevPos=positions[positions.size()-1];
+            if ( first||(delta*0.5<minDelta) )
+            {
+                failure=1;
+                if (success)
+                    failure=2;
+                failureCode=ikRes;
+                failPos=posAlongPath;
+                return(true);
+            }
+            // bisect: go back to the last good configuration and retry with a smaller step
+            for (size_t i=0;i<dof;i++)
+                ikSetJointPosition(jointHandles[i],prevConfig[i]);
+            delta*=0.5;
+            posAlongPath=std::min<double>(prevPos+delta,totalLength);
+            continue;
+        }
+        if ( (validator!=nullptr)&&(!validator->isValid(&config[0])) )
+        {
+            failure=3;
+            failureCode=validator->getCollidingPair();
+            failPos=posAlongPath;
+            return(true);
+        }
+        configs.insert(configs.end(),config.begin(),config.end());
+        positions.push_back(posAlongPath);
+        prevConfig.swap(config);
+        first=false;
+        if (fabs(posAlongPath-totalLength)<1e-6)
+            break;
+        if ( (!checkJointStep)||(jointStep<maxJointStep*0.5) )
+            delta=std::min<double>(delta*2.0,maxDelta);
+        posAlongPath=std::min<double>(posAlongPath+delta,totalLength);
+    }
+    return(true);
+}
+
+void LUA_SOLVEPATH_CALLBACK(SScriptCallBack* p)
+{
+    CScriptFunctionData D;
+    std::vector<double> configs;
+    std::vector<double> positions;
+    int failure=0;
+    int failureCode=0;
+    double failPos=-1.0;
+    bool result=false;
+    if (D.readDataFromStack(p->stackID,inArgs_SOLVEPATH,inArgs_SOLVEPATH[0]-2,LUA_SOLVEPATH_COMMAND))
+    {
+        std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
+        int envId=inData->at(0).int32Data[0];
+        int ikGroupHandle=inData->at(1).int32Data[0];
+        int ikTargetHandle=inData->at(2).int32Data[0];
+        const std::vector<int>& jointHandles=inData->at(3).int32Data;
+        int ikPathHandle=inData->at(4).int32Data[0];
+        const std::vector<double>& pathData=inData->at(5).doubleData;
+        const double* params=&inData->at(6).doubleData[0];
+        std::string err;
+        std::vector<int> noInts;
+        const std::vector<int>* simJoints=&noInts;
+        const std::vector<int>* collisionPairs=&noInts;
+        if (inData->size()>7)
+            simJoints=&inData->at(7).int32Data;
+        if (inData->size()>8)
+            collisionPairs=&inData->at(8).int32Data;
+        if ( (pathData.size()%7==0)&&(params[1]>0.0)&&(params[3]>=0.0) )
+        {
+            CEnvContext ctx(envId);
+            CConfigValidator validator;
+            if (!ctx.isValid())
+                err=_getLastError();
+            else if (validator.setup(noInts,noInts,std::vector<double>(),jointHandles,err)&&validator.setCollisionCheck(*simJoints,*collisionPairs,err))
+            {
+                CConfigValidator* nativeValidator=nullptr;
+                if (validator.hasValidators())
+                    nativeValidator=&validator;
+                _allSyncGroups->invalidateTargets(envId); // the IK target is moved along the path
+                result=_followPath(ikGroupHandle,ikTargetHandle,jointHandles,ikPathHandle,pathData,params,nativeValidator,configs,positions,failure,failureCode,failPos,err);
+                validator.restoreScene();
+            }
+        }
+        else
+            err="invalid arguments";
+        if (err.size()>0)
+            simSetLastError(LUA_SOLVEPATH_COMMAND,err.c_str());
+    }
+    if (result)
+    {
+        D.pushOutData(CScriptFunctionDataItem(configs));
+        D.pushOutData(CScriptFunctionDataItem(positions));
+        D.pushOutData(CScriptFunctionDataItem(failure));
+        D.pushOutData(CScriptFunctionDataItem(failureCode));
+        D.pushOutData(CScriptFunctionDataItem(failPos));
         D.writeDataToStack(p->stackID);
     }
-    if (retConfig!=nullptr)
-        delete[] retConfig;
 }
 // --------------------------------------------------------------------------------------
 
@@ -3269,8 +5618,8 @@ void LUA_GETOBJECTTRANSFORMATION_CALLBACK(SScriptCallBack* p)
         int relHandle=inData->at(2).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 C7Vector tr;
                 result=ikGetObjectTransformation(objHandle,relHandle,&tr);
@@ -3285,10 +5634,10 @@ void LUA_GETOBJECTTRANSFORMATION_CALLBACK(SScriptCallBack* p)
                     tr.Q.getEulerAngles().getData(e);
                 }
                 else
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETOBJECTTRANSFORMATION_COMMAND,err.c_str());
@@ -3339,10 +5688,11 @@ void LUA_SETOBJECTTRANSFORMATION_CALLBACK(SScriptCallBack* p)
             quat=&inData->at(4).doubleData[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {   // CoppeliaSim quaternion, internally: w x y z
                 // CoppeliaSim quaternion, at interfaces: x y z w
+                _allSyncGroups->invalidateTargets(envId); // target poses might change
                 C7Vector tr;
                 tr.X=C3Vector(pos);
                 if (euler!=nullptr)
@@ -3351,10 +5701,10 @@ void LUA_SETOBJECTTRANSFORMATION_CALLBACK(SScriptCallBack* p)
                     tr.Q=C4Vector(quat[3],quat[0],quat[1],quat[2]);
                 bool result=ikSetObjectTransformation(objHandle,relHandle,&tr);
                 if (!result)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_SETOBJECTTRANSFORMATION_COMMAND,err.c_str());
@@ -3388,8 +5738,8 @@ void LUA_GETOBJECTMATRIX_CALLBACK(SScriptCallBack* p)
         int relHandle=inData->at(2).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 C7Vector tr;
                 result=ikGetObjectTransformation(objHandle,relHandle,&tr);
@@ -3399,10 +5749,10 @@ void LUA_GETOBJECTMATRIX_CALLBACK(SScriptCallBack* p)
                     m.getData(matr);
                 }
                 else
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETOBJECTMATRIX_COMMAND,err.c_str());
@@ -3442,18 +5792,19 @@ void LUA_SETOBJECTMATRIX_CALLBACK(SScriptCallBack* p)
         double* m=&inData->at(3).doubleData[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
+                _allSyncGroups->invalidateTargets(envId); // target poses might change
                 C4X4Matrix _m;
                 _m.setData(m);
                 C7Vector tr(_m.getTransformation());
                 bool result=ikSetObjectTransformation(objHandle,relHandle,&tr);
                 if (!result)
-                    err=ikGetLastError();
+                    err=_getLastError();
             }
             else
-                err=ikGetLastError();
+                err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_SETOBJECTMATRIX_COMMAND,err.c_str());
@@ -3461,6 +5812,138 @@ void LUA_SETOBJECTMATRIX_CALLBACK(SScriptCallBack* p)
 }
 // --------------------------------------------------------------------------------------
 
+// --------------------------------------------------------------------------------------
+// simIK._getObjectPoses
+// --------------------------------------------------------------------------------------
+#define LUA_GETOBJECTPOSES_COMMAND_PLUGIN "simIK._getObjectPoses@IK"
+#define LUA_GETOBJECTPOSES_COMMAND "simIK._getObjectPoses"
+
+const int inArgs_GETOBJECTPOSES[]={
+    3,
+    sim_script_arg_int32,0,
+    sim_script_arg_int32|sim_script_arg_table,1, // object handles
+    sim_script_arg_int32|sim_script_arg_table,1, // relative-to handles: one for all, or one per object
+};
+
+void LUA_GETOBJECTPOSES_CALLBACK(SScriptCallBack* p)
+{
+    CScriptFunctionData D;
+    std::vector<double> poses;
+    bool result=false;
+    if (D.readDataFromStack(p->stackID,inArgs_GETOBJECTPOSES,inArgs_GETOBJECTPOSES[0],LUA_GETOBJECTPOSES_COMMAND))
+    {
+        std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
+        int envId=inData->at(0).int32Data[0];
+        const std::vector<int>& objHandles=inData->at(1).int32Data;
+        const std::vector<int>& relHandles=inData->at(2).int32Data;
+        std::string err;
+        if ( (relHandles.size()==1)||(relHandles.size()==objHandles.size()) )
+        {
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
+            {
+                poses.resize(objHandles.size()*7);
+                result=true;
+                for (size_t i=0;i<objHandles.size();i++)
+                {
+                    int relHandle=relHandles[0];
+                    if (relHandles.size()>1)
+                        relHandle=relHandles[i];
+                    C7Vector tr;
+                    if (ikGetObjectTransformation(objHandles[i],relHandle,&tr))
+                    {   // CoppeliaSim quaternion, internally: w x y z
+                        // CoppeliaSim quaternion, at interfaces: x y z w
+                        double* pose=&poses[7*i];
+                        tr.X.getData(pose);
+                        pose[3]=tr.Q(1);
+                        pose[4]=tr.Q(2);
+                        pose[5]=tr.Q(3);
+                        pose[6]=tr.Q(0);
+                    }
+                    else
+                    {
+                        err=_getLastError();
+                        result=false;
+                        break;
+                    }
+                }
+            }
+            else
+                err=_getLastError();
+        }
+        else
+            err="invalid arguments";
+        if (err.size()>0)
+            simSetLastError(LUA_GETOBJECTPOSES_COMMAND,err.c_str());
+    }
+    if (result)
+    {
+        D.pushOutData(CScriptFunctionDataItem(poses));
+        D.writeDataToStack(p->stackID);
+    }
+}
+// --------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------
+// simIK._setObjectPoses
+// --------------------------------------------------------------------------------------
+#define LUA_SETOBJECTPOSES_COMMAND_PLUGIN "simIK._setObjectPoses@IK"
+#define LUA_SETOBJECTPOSES_COMMAND "simIK._setObjectPoses"
+
+const int inArgs_SETOBJECTPOSES[]={
+    4,
+    sim_script_arg_int32,0,
+    sim_script_arg_int32|sim_script_arg_table,1, // object handles
+    sim_script_arg_int32|sim_script_arg_table,1, // relative-to handles: one for all, or one per object
+    sim_script_arg_double|sim_script_arg_table,7, // poses, 7 values per object
+};
+
+void LUA_SETOBJECTPOSES_CALLBACK(SScriptCallBack* p)
+{
+    CScriptFunctionData D;
+    if (D.readDataFromStack(p->stackID,inArgs_SETOBJECTPOSES,inArgs_SETOBJECTPOSES[0],LUA_SETOBJECTPOSES_COMMAND))
+    {
+        std::vector<CScriptFunctionDataItem>* inData=D.getInDataPtr();
+        int envId=inData->at(0).int32Data[0];
+        const std::vector<int>& objHandles=inData->at(1).int32Data;
+        const std::vector<int>& relHandles=inData->at(2).int32Data;
+        const std::vector<double>& poses=inData->at(3).doubleData;
+        std::string err;
+        if ( ( (relHandles.size()==1)||(relHandles.size()==objHandles.size()) )&&(poses.size()==objHandles.size()*7) )
+        {
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
+            {
+                _allSyncGroups->invalidateTargets(envId); // target poses might change
+                for (size_t i=0;i<objHandles.size();i++)
+                {
+                    int relHandle=relHandles[0];
+                    if (relHandles.size()>1)
+                        relHandle=relHandles[i];
+                    // CoppeliaSim quaternion, internally: w x y z
+                    // CoppeliaSim quaternion, at interfaces: x y z w
+                    const double* pose=&poses[7*i];
+                    C7Vector tr;
+                    tr.X=C3Vector(pose[0],pose[1],pose[2]);
+                    tr.Q=C4Vector(pose[6],pose[3],pose[4],pose[5]);
+                    if (!ikSetObjectTransformation(objHandles[i],relHandle,&tr))
+                    {
+                        err=_getLastError();
+                        break;
+                    }
+                }
+            }
+            else
+                err=_getLastError();
+        }
+        else
+            err="invalid arguments";
+        if (err.size()>0)
+            simSetLastError(LUA_SETOBJECTPOSES_COMMAND,err.c_str());
+    }
+}
+// --------------------------------------------------------------------------------------
+
 // --------------------------------------------------------------------------------------
 // simIK.computeJacobian
 // --------------------------------------------------------------------------------------
@@ -3544,8 +6027,8 @@ void LUA_COMPUTEJACOBIAN_CALLBACK(SScriptCallBack* p)
                 {
                     std::vector<double> jacobian;
                     std::vector<double> errorVect;
-                    CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-                    if (ikSwitchEnvironment(envId))
+                    CEnvContext ctx(envId);
+                    if (ctx.isValid())
                     {
                         if (ikComputeJacobian(baseHandle,jointHandle,constraints,&tipPose,&targetPose,_altBase,&jacobian,&errorVect))
                         {
@@ -3554,10 +6037,10 @@ void LUA_COMPUTEJACOBIAN_CALLBACK(SScriptCallBack* p)
                             D.writeDataToStack(p->stackID);
                         }
                         else
-                            err=ikGetLastError();
+                            err=_getLastError();
                     }
                     else
-                        err=ikGetLastError();
+                        err=_getLastError();
                 }
                 else
                     err="invalid arguments";
@@ -3567,8 +6050,8 @@ void LUA_COMPUTEJACOBIAN_CALLBACK(SScriptCallBack* p)
         }
         else
         { // old, for backw. compatibility
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 int ikGroupHandle=inData->at(1).int32Data[0];
                 int options=inData->at(2).int32Data[0];
@@ -3581,10 +6064,10 @@ void LUA_COMPUTEJACOBIAN_CALLBACK(SScriptCallBack* p)
                     D.writeDataToStack(p->stackID);
                 }
                 else
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_COMPUTEJACOBIAN_COMMAND,err.c_str());
@@ -3615,8 +6098,8 @@ void LUA_COMPUTEGROUPJACOBIAN_CALLBACK(SScriptCallBack* p)
         int groupHandle=inData->at(1).int32Data[0];
         std::vector<double> jacobian;
         std::vector<double> errorVect;
-        CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-        if (ikSwitchEnvironment(envId))
+        CEnvContext ctx(envId);
+        if (ctx.isValid())
         {
             if (ikComputeGroupJacobian(groupHandle,&jacobian,&errorVect))
             {
@@ -3625,10 +6108,10 @@ void LUA_COMPUTEGROUPJACOBIAN_CALLBACK(SScriptCallBack* p)
                 D.writeDataToStack(p->stackID);
             }
             else
-                err=ikGetLastError();
+                err=_getLastError();
         }
         else
-            err=ikGetLastError();
+            err=_getLastError();
         if (err.size()>0)
             simSetLastError(LUA_COMPUTEGROUPJACOBIAN_COMMAND,err.c_str());
     }
@@ -3659,11 +6142,11 @@ void LUA_GETJACOBIAN_CALLBACK(SScriptCallBack* p)
         int ikGroupHandle=inData->at(1).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
                 matr=ikGetJacobian_old(ikGroupHandle,matrSize);
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETJACOBIAN_COMMAND,err.c_str());
@@ -3706,15 +6189,15 @@ void LUA_GETMANIPULABILITY_CALLBACK(SScriptCallBack* p)
         int ikGroupHandle=inData->at(1).int32Data[0];
         std::string err;
         {
-            CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-            if (ikSwitchEnvironment(envId))
+            CEnvContext ctx(envId);
+            if (ctx.isValid())
             {
                 success=ikGetManipulability_old(ikGroupHandle,&retVal);
                 if (!success)
-                     err=ikGetLastError();
+                     err=_getLastError();
             }
             else
-                 err=ikGetLastError();
+                 err=_getLastError();
         }
         if (err.size()>0)
             simSetLastError(LUA_GETMANIPULABILITY_COMMAND,err.c_str());
@@ -3771,7 +6254,7 @@ SIM_DLLEXPORT unsigned char simStart(void*,int)
     // Register the new Lua commands:
     simRegisterScriptCallbackFunction(LUA_CREATEENVIRONMENT_COMMAND_PLUGIN,strConCat("int environmentHandle=",LUA_CREATEENVIRONMENT_COMMAND,"(int flags=0)"),LUA_CREATEENVIRONMENT_CALLBACK);
     simRegisterScriptCallbackFunction(LUA_ERASEENVIRONMENT_COMMAND_PLUGIN,nullptr,LUA_ERASEENVIRONMENT_CALLBACK);
-    simRegisterScriptCallbackFunction(LUA_DUPLICATEENVIRONMENT_COMMAND_PLUGIN,strConCat("int duplicateEnvHandle=",LUA_DUPLICATEENVIRONMENT_COMMAND,"(int environmentHandle)"),LUA_DUPLICATEENVIRONMENT_CALLBACK);
+    simRegisterScriptCallbackFunction(LUA_DUPLICATEENVIRONMENT_COMMAND_PLUGIN,strConCat("int duplicateEnvHandle=",LUA_DUPLICATEENVIRONMENT_COMMAND,"(int environmentHandle,bool pooled=false)"),LUA_DUPLICATEENVIRONMENT_CALLBACK);
     simRegisterScriptCallbackFunction(LUA_LOAD_COMMAND_PLUGIN,strConCat("",LUA_LOAD_COMMAND,"(int environmentHandle,string data)"),LUA_LOAD_CALLBACK);
     simRegisterScriptCallbackFunction(LUA_SAVE_COMMAND_PLUGIN,strConCat("string data=",LUA_SAVE_COMMAND,"(int environmentHandle)"),LUA_SAVE_CALLBACK);
     simRegisterScriptCallbackFunction(LUA_GETOBJECTS_COMMAND_PLUGIN,strConCat("int objectHandle,string objectName,bool isJoint,int jointType=",LUA_GETOBJECTS_COMMAND,"(int environmentHandle,int index)"),LUA_GETOBJECTS_CALLBACK);
@@ -3806,6 +6289,10 @@ SIM_DLLEXPORT unsigned char simStart(void*,int)
     simRegisterScriptCallbackFunction(LUA_SETSPHERICALJOINTMATRIX_COMMAND_PLUGIN,strConCat("",LUA_SETSPHERICALJOINTMATRIX_COMMAND,"(int environmentHandle,int jointHandle,float[12] matrix)"),LUA_SETSPHERICALJOINTMATRIX_CALLBACK);
     simRegisterScriptCallbackFunction(LUA_GETJOINTTRANSFORMATION_COMMAND_PLUGIN,strConCat("float[3] position,float[4] quaternion,float[3] euler=",LUA_GETJOINTTRANSFORMATION_COMMAND,"(int environmentHandle,int jointHandle)"),LUA_GETJOINTTRANSFORMATION_CALLBACK);
     simRegisterScriptCallbackFunction(LUA_SETSPHERICALJOINTROTATION_COMMAND_PLUGIN,strConCat("",LUA_SETSPHERICALJOINTROTATION_COMMAND,"(int environmentHandle,int jointHandle,float[] eulerOrQuaternion)"),LUA_SETSPHERICALJOINTROTATION_CALLBACK);
+    simRegisterScriptCallbackFunction(LUA_GETJOINTPOSITIONS_COMMAND_PLUGIN,strConCat("float[] positions=",LUA_GETJOINTPOSITIONS_COMMAND,"(int environmentHandle,int[] jointHandles)"),LUA_GETJOINTPOSITIONS_CALLBACK);
+    simRegisterScriptCallbackFunction(LUA_SETJOINTPOSITIONS_COMMAND_PLUGIN,strConCat("",LUA_SETJOINTPOSITIONS_COMMAND,"(int environmentHandle,int[] jointHandles,float[] positions)"),LUA_SETJOINTPOSITIONS_CALLBACK);
+    simRegisterScriptCallbackFunction(LUA_GETJOINTMATRICES_COMMAND_PLUGIN,strConCat("float[] matrices=",LUA_GETJOINTMATRICES_COMMAND,"(int environmentHandle,int[] jointHandles)"),LUA_GETJOINTMATRICES_CALLBACK);
+    simRegisterScriptCallbackFunction(LUA_SETSPHERICALJOINTMATRICES_COMMAND_PLUGIN,strConCat("",LUA_SETSPHERICALJOINTMATRICES_COMMAND,"(int environmentHandle,int[] jointHandles,float[] matrices)"),LUA_SETSPHERICALJOINTMATRICES_CALLBACK);
     simRegisterScriptCallbackFunction(LUA_GETIKGROUPHANDLE_COMMAND_PLUGIN,strConCat("int ikGroupHandle=",LUA_GETIKGROUPHANDLE_COMMAND,"(int environmentHandle,string ikGroupName)"),LUA_GETIKGROUPHANDLE_CALLBACK);
     simRegisterScriptCallbackFunction(LUA_DOESIKGROUPEXIST_COMMAND_PLUGIN,strConCat("bool result=",LUA_DOESIKGROUPEXIST_COMMAND,"(int environmentHandle,string ikGroupName)"),LUA_DOESIKGROUPEXIST_CALLBACK);
     simRegisterScriptCallbackFunction(LUA_CREATEIKGROUP_COMMAND_PLUGIN,strConCat("int ikGroupHandle=",LUA_CREATEIKGROUP_COMMAND,"(int environmentHandle,string ikGroupName='')"),LUA_CREATEIKGROUP_CALLBACK);
@@ -3827,12 +6314,29 @@ SIM_DLLEXPORT unsigned char simStart(void*,int)
     simRegisterScriptCallbackFunction(LUA_GETIKELEMENTWEIGHTS_COMMAND_PLUGIN,strConCat("float[2] weights=",LUA_GETIKELEMENTWEIGHTS_COMMAND,"(int environmentHandle,int ikGroupHandle,int elementHandle)"),LUA_GETIKELEMENTWEIGHTS_CALLBACK);
     simRegisterScriptCallbackFunction(LUA_SETIKELEMENTWEIGHTS_COMMAND_PLUGIN,strConCat("",LUA_SETIKELEMENTWEIGHTS_COMMAND,"(int environmentHandle,int ikGroupHandle,int elementHandle,float[2] weights)"),LUA_SETIKELEMENTWEIGHTS_CALLBACK);
     simRegisterScriptCallbackFunction(LUA_HANDLEIKGROUPS_COMMAND_PLUGIN,nullptr,LUA_HANDLEIKGROUPS_CALLBACK);
+    simRegisterScriptCallbackFunction(LUA_HANDLEIKGROUPSMULTI_COMMAND_PLUGIN,nullptr,LUA_HANDLEIKGROUPSMULTI_CALLBACK);
+    simRegisterScriptCallbackFunction(LUA_SETSYNCGROUP_COMMAND_PLUGIN,nullptr,LUA_SETSYNCGROUP_CALLBACK);
+    simRegisterScriptCallbackFunction(LUA_SYNCFROMSIM_COMMAND_PLUGIN,nullptr,LUA_SYNCFROMSIM_CALLBACK);
+    simRegisterScriptCallbackFunction(LUA_SYNCTOSIM_COMMAND_PLUGIN,nullptr,LUA_SYNCTOSIM_CALLBACK);
     simRegisterScriptCallbackFunction(LUA_GETCONFIGFORTIPPOSE_COMMAND_PLUGIN,nullptr,LUA_GETCONFIGFORTIPPOSE_CALLBACK);
     simRegisterScriptCallbackFunction(LUA_FINDCONFIG_COMMAND_PLUGIN,nullptr,LUA_FINDCONFIG_CALLBACK);
+    simRegisterScriptCallbackFunction(LUA_GENERATEPATH_COMMAND_PLUGIN,nullptr,LUA_GENERATEPATH_CALLBACK);
+    simRegisterScriptCallbackFunction(LUA_SOLVEPATH_COMMAND_PLUGIN,nullptr,LUA_SOLVEPATH_CALLBACK);
+    simRegisterScriptCallbackFunction(LUA_GETCONFIGSEARCHSTATS_COMMAND_PLUGIN,nullptr,LUA_GETCONFIGSEARCHSTATS_CALLBACK);
+    simRegisterScriptCallbackFunction(LUA_GETCONFIGCACHESTATS_COMMAND_PLUGIN,strConCat("int hits,int misses,int entries=",LUA_GETCONFIGCACHESTATS_COMMAND,"(int environmentHandle,int ikGroupHandle,bool clear=false)"),LUA_GETCONFIGCACHESTATS_CALLBACK);
+    simRegisterScriptCallbackFunction(LUA_GETALTERNATECONFIGS_COMMAND_PLUGIN,strConCat("float[] configs=",LUA_GETALTERNATECONFIGS_COMMAND,"(int environmentHandle,int[] jointHandles,float[] lowLimits=nil,float[] ranges=nil)"),LUA_GETALTERNATECONFIGS_CALLBACK);
+    simRegisterScriptCallbackFunction(LUA_CREATEALTCONFIGITERATOR_COMMAND_PLUGIN,strConCat("int iteratorHandle=",LUA_CREATEALTCONFIGITERATOR_COMMAND,"(int environmentHandle,int[] jointHandles,float[] lowLimits=nil,float[] ranges=nil)"),LUA_CREATEALTCONFIGITERATOR_CALLBACK);
+    simRegisterScriptCallbackFunction(LUA_GETNEXTALTCONFIGS_COMMAND_PLUGIN,strConCat("float[] configs=",LUA_GETNEXTALTCONFIGS_COMMAND,"(int iteratorHandle,int batchSize=1)"),LUA_GETNEXTALTCONFIGS_CALLBACK);
+    simRegisterScriptCallbackFunction(LUA_ERASEALTCONFIGITERATOR_COMMAND_PLUGIN,strConCat("",LUA_ERASEALTCONFIGITERATOR_COMMAND,"(int iteratorHandle)"),LUA_ERASEALTCONFIGITERATOR_CALLBACK);
+    simRegisterScriptCallbackFunction(LUA_SAVESTATE_COMMAND_PLUGIN,strConCat("int stateHandle=",LUA_SAVESTATE_COMMAND,"(int environmentHandle,int[] objectHandles=nil)"),LUA_SAVESTATE_CALLBACK);
+    simRegisterScriptCallbackFunction(LUA_RESTORESTATE_COMMAND_PLUGIN,strConCat("",LUA_RESTORESTATE_COMMAND,"(int environmentHandle,int stateHandle)"),LUA_RESTORESTATE_CALLBACK);
+    simRegisterScriptCallbackFunction(LUA_ERASESTATE_COMMAND_PLUGIN,strConCat("",LUA_ERASESTATE_COMMAND,"(int stateHandle)"),LUA_ERASESTATE_CALLBACK);
     simRegisterScriptCallbackFunction(LUA_GETOBJECTTRANSFORMATION_COMMAND_PLUGIN,strConCat("float[3] position,float[4] quaternion,float[3] euler=",LUA_GETOBJECTTRANSFORMATION_COMMAND,"(int environmentHandle,int objectHandle,int relativeToObjectHandle)"),LUA_GETOBJECTTRANSFORMATION_CALLBACK);
     simRegisterScriptCallbackFunction(LUA_SETOBJECTTRANSFORMATION_COMMAND_PLUGIN,strConCat("",LUA_SETOBJECTTRANSFORMATION_COMMAND,"(int environmentHandle,int objectHandle,int relativeToObjectHandle,float[3] position,float[] eulerOrQuaternion)"),LUA_SETOBJECTTRANSFORMATION_CALLBACK);
     simRegisterScriptCallbackFunction(LUA_GETOBJECTMATRIX_COMMAND_PLUGIN,strConCat("float[12] matrix=",LUA_GETOBJECTMATRIX_COMMAND,"(int environmentHandle,int objectHandle,int relativeToObjectHandle)"),LUA_GETOBJECTMATRIX_CALLBACK);
     simRegisterScriptCallbackFunction(LUA_SETOBJECTMATRIX_COMMAND_PLUGIN,strConCat("",LUA_SETOBJECTMATRIX_COMMAND,"(int environmentHandle,int objectHandle,int relativeToObjectHandle,float[12] matrix)"),LUA_SETOBJECTMATRIX_CALLBACK);
+    simRegisterScriptCallbackFunction(LUA_GETOBJECTPOSES_COMMAND_PLUGIN,nullptr,LUA_GETOBJECTPOSES_CALLBACK);
+    simRegisterScriptCallbackFunction(LUA_SETOBJECTPOSES_COMMAND_PLUGIN,nullptr,LUA_SETOBJECTPOSES_CALLBACK);
     simRegisterScriptCallbackFunction(LUA_COMPUTEJACOBIAN_COMMAND_PLUGIN,strConCat("float[] jacobian,float[] errorVector=",LUA_COMPUTEJACOBIAN_COMMAND,"(int environmentHandle,int baseObject,int lastJoint,int constraints,float[7..12] tipMatrix,float[7..12] targetMatrix=nil,float[7..12] constrBaseMatrix=nil)"),LUA_COMPUTEJACOBIAN_CALLBACK);
     simRegisterScriptCallbackFunction(LUA_COMPUTEGROUPJACOBIAN_COMMAND_PLUGIN,strConCat("float[] jacobian,float[] errorVector=",LUA_COMPUTEGROUPJACOBIAN_COMMAND,"(int environmentHandle,int ikGroupHandle)"),LUA_COMPUTEGROUPJACOBIAN_CALLBACK);
 
@@ -3877,6 +6381,16 @@ SIM_DLLEXPORT unsigned char simStart(void*,int)
     simRegisterScriptVariable("simIK.group_restoreonbadangtol@simExtIK",std::to_string(ik_group_restoreonbadangtol).c_str(),0);
     simRegisterScriptVariable("simIK.group_stoponlimithit@simExtIK",std::to_string(ik_group_stoponlimithit).c_str(),0);
     simRegisterScriptVariable("simIK.group_avoidlimits@simExtIK",std::to_string(ik_group_avoidlimits).c_str(),0);
+    simRegisterScriptVariable("simIK.sampling_random@simExtIK",std::to_string(sampling_random).c_str(),0);
+    simRegisterScriptVariable("simIK.sampling_sobol@simExtIK",std::to_string(sampling_sobol).c_str(),0);
+    simRegisterScriptVariable("simIK.sampling_halton@simExtIK",std::to_string(sampling_halton).c_str(),0);
+    simRegisterScriptVariable("simIK.sampling_stratified@simExtIK",std::to_string(sampling_stratified).c_str(),0);
+    simRegisterScriptVariable("simIK.validator_jointlimitmargin@simExtIK",std::to_string(validator_jointlimitmargin).c_str(),0);
+    simRegisterScriptVariable("simIK.validator_mindistance@simExtIK",std::to_string(validator_mindistance).c_str(),0);
+    simRegisterScriptVariable("simIK.validator_orientationcone@simExtIK",std::to_string(validator_orientationcone).c_str(),0);
+    simRegisterScriptVariable("simIK.dependency_polynomial@simExtIK",std::to_string(dependency_polynomial).c_str(),0);
+    simRegisterScriptVariable("simIK.dependency_lookup@simExtIK",std::to_string(dependency_lookup).c_str(),0);
+    simRegisterScriptVariable("simIK.dependency_spline@simExtIK",std::to_string(dependency_spline).c_str(),0);
 
     // deprecated:
     simRegisterScriptCallbackFunction(LUA_GETJOINTSCREWPITCH_COMMAND_PLUGIN,nullptr,LUA_GETJOINTSCREWPITCH_CALLBACK);
@@ -3916,6 +6430,9 @@ SIM_DLLEXPORT unsigned char simStart(void*,int)
     #endif
 
     _allEnvironments=new CEnvCont();
+    _allSyncGroups=new CSyncCont();
+    _configCache=new CConfigCache();
+    _envPool=new CEnvPool();
 
     return(2); // 2 since V4.3.0
 }
@@ -3923,6 +6440,9 @@ SIM_DLLEXPORT unsigned char simStart(void*,int)
 SIM_DLLEXPORT void simEnd()
 {
     delete _allEnvironments;
+    delete _allSyncGroups;
+    delete _configCache;
+    delete _envPool;
 #ifdef _WIN32
     DeleteCriticalSection(&_simpleMutex);
 #else
@@ -3934,21 +6454,39 @@ SIM_DLLEXPORT void* simMessage(int message,int* auxiliaryData,void*,int*)
 {
     if (message==sim_message_eventcallback_scriptstatedestroyed)
     {
-        int env=_allEnvironments->removeOneFromScriptHandle(auxiliaryData[0]);
-        while (env>=0)
+        CLockInterface lock;
+        std::vector<int> envs=_allEnvironments->removeAllFromScriptHandle(auxiliaryData[0]);
+        for (size_t i=0;i<envs.size();i++)
         {
-            if (ikSwitchEnvironment(env))
-                ikEraseEnvironment();
-            env=_allEnvironments->removeOneFromScriptHandle(auxiliaryData[0]);
-
-            for (int i=0;i<int(jointDependInfo.size());i++)
-            {
-                if (jointDependInfo[i].scriptHandle==auxiliaryData[0])
-                {
-                    jointDependInfo.erase(jointDependInfo.begin()+i);
-                    i--;
-                }
-            }
+            int env=envs[i];
+            _eraseUserEnvironment(env);
+            _allSyncGroups->removeEnv(env);
+            _configCache->removeEnv(env);
+            _eraseEnvClones(_envPool->removeEnv(env));
+        }
+        // one pass over the joint dependencies. The script might also have registered callbacks for environments it does not own:
+        std::unordered_set<int> erasedEnvs(envs.begin(),envs.end());
+        for (auto it=jointDependInfo.begin();it!=jointDependInfo.end();)
+        {
+            if ( (erasedEnvs.count(it->second.ikEnv)>0)||it->second.func.belongsTo(auxiliaryData[0]) )
+                it=jointDependInfo.erase(it);
+            else
+                ++it;
+        }
+        CEnvContext::invalidateScript(auxiliaryData[0]);
+        for (auto it=altConfigIterators.begin();it!=altConfigIterators.end();)
+        {
+            if (it->second.scriptHandle==auxiliaryData[0])
+                it=altConfigIterators.erase(it);
+            else
+                ++it;
+        }
+        for (auto it=envStates.begin();it!=envStates.end();)
+        {
+            if (it->second.scriptHandle==auxiliaryData[0])
+                it=envStates.erase(it);
+            else
+                ++it;
         }
     }
 
@@ -3984,27 +6522,28 @@ SIM_DLLEXPORT int ikPlugin_createEnv()
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
     int retVal=-1;
     ikCreateEnvironment(&retVal,1|2); // protected (1) and backward compatible for old GUI-IK(2)
+    _invalidateCurrentEnvironment();
     return(retVal);
 }
 
 SIM_DLLEXPORT void ikPlugin_eraseEnvironment(int ikEnv)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikEraseEnvironment();
 }
 
 SIM_DLLEXPORT void ikPlugin_eraseObject(int ikEnv,int objectHandle)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikEraseObject(objectHandle);
 }
 
 SIM_DLLEXPORT void ikPlugin_setObjectParent(int ikEnv,int objectHandle,int parentObjectHandle)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikSetObjectParent(objectHandle,parentObjectHandle,false);
 }
 
@@ -4012,7 +6551,7 @@ SIM_DLLEXPORT int ikPlugin_createDummy(int ikEnv)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
     int retVal=-1;
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikCreateDummy(nullptr,&retVal);
     return(retVal);
 }
@@ -4020,7 +6559,7 @@ SIM_DLLEXPORT int ikPlugin_createDummy(int ikEnv)
 SIM_DLLEXPORT void ikPlugin_setLinkedDummy(int ikEnv,int dummyHandle,int linkedDummyHandle)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikSetLinkedDummy(dummyHandle,linkedDummyHandle);
 }
 
@@ -4028,7 +6567,7 @@ SIM_DLLEXPORT int ikPlugin_createJoint(int ikEnv,int jointType)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
     int retVal=-1;
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikCreateJoint(nullptr,jointType,&retVal);
     return(retVal);
 }
@@ -4036,14 +6575,14 @@ SIM_DLLEXPORT int ikPlugin_createJoint(int ikEnv,int jointType)
 SIM_DLLEXPORT void ikPlugin_setJointMode(int ikEnv,int jointHandle,int jointMode)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikSetJointMode(jointHandle,jointMode);
 }
 
 SIM_DLLEXPORT void ikPlugin_setJointInterval(int ikEnv,int jointHandle,bool cyclic,const double* intervalMinAndRange)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
     {
 #ifdef switchToDouble
         ikSetJointInterval(jointHandle,cyclic,intervalMinAndRange);
@@ -4057,28 +6596,28 @@ SIM_DLLEXPORT void ikPlugin_setJointInterval(int ikEnv,int jointHandle,bool cycl
 SIM_DLLEXPORT void ikPlugin_setJointScrewPitch(int ikEnv,int jointHandle,double pitch)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikSetJointScrewPitch(jointHandle,pitch);
 }
 
 SIM_DLLEXPORT void ikPlugin_setJointIkWeight(int ikEnv,int jointHandle,double ikWeight)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikSetJointWeight(jointHandle,ikWeight);
 }
 
 SIM_DLLEXPORT void ikPlugin_setJointMaxStepSize(int ikEnv,int jointHandle,double maxStepSize)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikSetJointMaxStepSize(jointHandle,maxStepSize);
 }
 
 SIM_DLLEXPORT void ikPlugin_setJointDependency(int ikEnv,int jointHandle,int dependencyJointHandle,double offset,double mult)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikSetJointDependency(jointHandle,dependencyJointHandle,offset,mult);
 }
 
@@ -4086,7 +6625,7 @@ SIM_DLLEXPORT double ikPlugin_getJointPosition(int ikEnv,int jointHandle)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
     double p=0.0;
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikGetJointPosition(jointHandle,&p);
     return(p);
 }
@@ -4094,7 +6633,7 @@ SIM_DLLEXPORT double ikPlugin_getJointPosition(int ikEnv,int jointHandle)
 SIM_DLLEXPORT void ikPlugin_setJointPosition(int ikEnv,int jointHandle,double position)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikSetJointPosition(jointHandle,position);
 }
 
@@ -4103,7 +6642,7 @@ SIM_DLLEXPORT void ikPlugin_getSphericalJointQuaternion(int ikEnv,int jointHandl
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
     C7Vector tr;
     tr.setIdentity();
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikGetJointTransformation(jointHandle,&tr);
     quaternion[0]=tr.Q(0);
     quaternion[1]=tr.Q(1);
@@ -4119,7 +6658,7 @@ SIM_DLLEXPORT void ikPlugin_setSphericalJointQuaternion(int ikEnv,int jointHandl
     q(1)=quaternion[1];
     q(2)=quaternion[2];
     q(3)=quaternion[3];
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikSetSphericalJointQuaternion(jointHandle,&q);
 }
 
@@ -4127,7 +6666,7 @@ SIM_DLLEXPORT int ikPlugin_createIkGroup(int ikEnv)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
     int retVal=-1;
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikCreateGroup(nullptr,&retVal);
     return(retVal);
 }
@@ -4135,21 +6674,21 @@ SIM_DLLEXPORT int ikPlugin_createIkGroup(int ikEnv)
 SIM_DLLEXPORT void ikPlugin_eraseIkGroup(int ikEnv,int ikGroupHandle)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikEraseGroup(ikGroupHandle);
 }
 
 SIM_DLLEXPORT void ikPlugin_setIkGroupFlags(int ikEnv,int ikGroupHandle,int flags)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikSetGroupFlags(ikGroupHandle,flags);
 }
 
 SIM_DLLEXPORT void ikPlugin_setIkGroupCalculation(int ikEnv,int ikGroupHandle,int method,double damping,int maxIterations)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikSetGroupCalculation(ikGroupHandle,method,damping,maxIterations);
 }
 
@@ -4157,7 +6696,7 @@ SIM_DLLEXPORT int ikPlugin_addIkElement(int ikEnv,int ikGroupHandle,int tipHandl
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
     int retVal=-1;
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikAddElement(ikGroupHandle,tipHandle,&retVal);
     return(retVal);
 }
@@ -4165,42 +6704,42 @@ SIM_DLLEXPORT int ikPlugin_addIkElement(int ikEnv,int ikGroupHandle,int tipHandl
 SIM_DLLEXPORT void ikPlugin_eraseIkElement(int ikEnv,int ikGroupHandle,int ikElementHandle)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikEraseElement(ikGroupHandle,ikElementHandle);
 }
 
 SIM_DLLEXPORT void ikPlugin_setIkElementFlags(int ikEnv,int ikGroupHandle,int ikElementHandle,int flags)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikSetElementFlags(ikGroupHandle,ikElementHandle,flags);
 }
 
 SIM_DLLEXPORT void ikPlugin_setIkElementBase(int ikEnv,int ikGroupHandle,int ikElementHandle,int baseHandle,int constraintsBaseHandle)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikSetElementBase(ikGroupHandle,ikElementHandle,baseHandle,constraintsBaseHandle);
 }
 
 SIM_DLLEXPORT void ikPlugin_setIkElementConstraints(int ikEnv,int ikGroupHandle,int ikElementHandle,int constraints)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikSetElementConstraints(ikGroupHandle,ikElementHandle,constraints);
 }
 
 SIM_DLLEXPORT void ikPlugin_setIkElementPrecision(int ikEnv,int ikGroupHandle,int ikElementHandle,double linearPrecision,double angularPrecision)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikSetElementPrecision(ikGroupHandle,ikElementHandle,linearPrecision,angularPrecision);
 }
 
 SIM_DLLEXPORT void ikPlugin_setIkElementWeights(int ikEnv,int ikGroupHandle,int ikElementHandle,double linearWeight,double angularWeight)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikSetElementWeights(ikGroupHandle,ikElementHandle,linearWeight,angularWeight,1.0);
 }
 
@@ -4208,16 +6747,12 @@ SIM_DLLEXPORT int ikPlugin_handleIkGroup(int ikEnv,int ikGroupHandle)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
     int retVal=-1;
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
     {
         std::vector<int> gr;
         gr.push_back(ikGroupHandle);
         ikHandleGroups(&gr,&retVal,nullptr);
-        if ( (retVal&ik_calc_notperformed)!=0 )
-            retVal=0; // ik_result_not_performed
-        else if ( (retVal&(ik_calc_cannotinvert|ik_calc_notwithintolerance))!=0 )
-            retVal=2; // previously ik_result_fail
-        else retVal=1; // previously ik_result_success
+        retVal=_getResultFromCalcFlags(retVal);
     }
     return(retVal);
 }
@@ -4226,7 +6761,7 @@ SIM_DLLEXPORT bool ikPlugin_computeJacobian(int ikEnv,int ikGroupHandle,int opti
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
     bool retVal=false;
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikComputeJacobian_old(ikGroupHandle,options,&retVal);
     return(retVal);
 }
@@ -4235,7 +6770,7 @@ SIM_DLLEXPORT double* ikPlugin_getJacobian(int ikEnv,int ikGroupHandle,int* matr
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
     double* retVal=nullptr;
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
     {
         size_t ms[2];
         double* m=ikGetJacobian_old(ikGroupHandle,ms);
@@ -4256,7 +6791,7 @@ SIM_DLLEXPORT double ikPlugin_getManipulability(int ikEnv,int ikGroupHandle)
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
     double retVal=0.0;
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikGetManipulability_old(ikGroupHandle,&retVal);
     return(retVal);
 }
@@ -4266,7 +6801,7 @@ SIM_DLLEXPORT void ikPlugin_getObjectLocalTransformation(int ikEnv,int objectHan
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
     C7Vector tr;
     tr.setIdentity();
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikGetObjectTransformation(objectHandle,ik_handle_parent,&tr);
     pos[0]=tr.X(0);
     pos[1]=tr.X(1);
@@ -4288,7 +6823,7 @@ SIM_DLLEXPORT void ikPlugin_setObjectLocalTransformation(int ikEnv,int objectHan
     tr.Q(1)=quat[1];
     tr.Q(2)=quat[2];
     tr.Q(3)=quat[3];
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
         ikSetObjectTransformation(objectHandle,ik_handle_parent,&tr);
 }
 
@@ -4307,7 +6842,7 @@ SIM_DLLEXPORT char* ikPlugin_getConfigForTipPose(int ikEnv,int ikGroupHandle,int
 {
     CLockInterface lock; // actually required to correctly support CoppeliaSim's old GUI-based IK
     char* retVal=nullptr;
-    if (ikSwitchEnvironment(ikEnv,true))
+    if (_selectEnvironment(ikEnv,true))
     {
         std::vector<double> _retConfig;
         _retConfig.resize(size_t(jointCnt));
@@ -4353,7 +6888,7 @@ SIM_DLLEXPORT char* ikPlugin_getConfigForTipPose(int ikEnv,int ikGroupHandle,int
         }
         if (result[0]<0)
         {
-            std::string err(ikGetLastError());
+            std::string err(_getLastError());
             retVal=(char*)simCreateBuffer(int(err.size()+1));
             for (size_t i=0;i<err.size();i++)
                 retVal[i]=err[i];
@@ -57,6 +57,12 @@ INCLUDEPATH += $$EIGEN_INCLUDEPATH
 
 HEADERS += simExtIK.h \
     envCont.h \
+    syncCont.h \
+    configSampler.h \
+    configCache.h \
+    configValidator.h \
+    jointDependency.h \
+    envPool.h \
     ../include/simLib/simLib.h \
     ../include/simLib/scriptFunctionData.h \
     ../include/simLib/scriptFunctionDataItem.h \
@@ -81,6 +87,12 @@ HEADERS += simExtIK.h \
 
 SOURCES += simExtIK.cpp \
     envCont.cpp \
+    syncCont.cpp \
+    configSampler.cpp \
+    configCache.cpp \
+    configValidator.cpp \
+    jointDependency.cpp \
+    envPool.cpp \
     ../include/simLib/simLib.cpp \
     ../include/simLib/scriptFunctionData.cpp \
     ../include/simLib/scriptFunctionDataItem.cpp \
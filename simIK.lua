@@ -1,186 +1,90 @@
 local simIK={}
 
-function _S.simIKLoopThroughAltConfigSolutions(ikEnvironment,jointHandles,desiredPose,confS,x,index)
-    if index>#jointHandles then
-        return {sim.unpackDoubleTable(sim.packDoubleTable(confS))} -- copy the table
-    else
-        local c={}
-        for i=1,#jointHandles,1 do
-            c[i]=confS[i]
-        end
-        local solutions={}
-        while c[index]<=x[index][2] do
-            local s=_S.simIKLoopThroughAltConfigSolutions(ikEnvironment,jointHandles,desiredPose,c,x,index+1,tipHandle)
-            for i=1,#s,1 do
-                solutions[#solutions+1]=s[i]
-            end
-            c[index]=c[index]+math.pi*2
+function _S.simIKPackValidators(validators)
+    -- flattens native validator specs into types, int parameters and double parameters
+    local types,ints,doubles={},{},{}
+    for i=1,#validators,1 do
+        local v=validators[i]
+        types[#types+1]=v.type
+        if v.type==simIK.validator_jointlimitmargin then
+            doubles[#doubles+1]=v.margin or 0
+        elseif v.type==simIK.validator_mindistance then
+            ints[#ints+1]=v.objects[1]
+            ints[#ints+1]=v.objects[2]
+            doubles[#doubles+1]=v.distance
+        elseif v.type==simIK.validator_orientationcone then
+            ints[#ints+1]=v.tip
+            ints[#ints+1]=v.relativeTo or simIK.handle_world
+            local axis=v.axis or {0,0,1}
+            doubles[#doubles+1]=axis[1]
+            doubles[#doubles+1]=axis[2]
+            doubles[#doubles+1]=axis[3]
+            doubles[#doubles+1]=v.angle
+        else
+            error('invalid validator type')
         end
-        return solutions
     end
+    return types,ints,doubles
 end
 
-function simIK.getAlternateConfigs(...)
-    local ikEnvironment,jointHandles,lowLimits,ranges=checkargs({{type='int'},{type='table',size='1..*',item_type='int'},{type='table',size='1..*',item_type='float',default=NIL,nullable=true},{type='table',size='1..*',item_type='float',default=NIL,nullable=true}},...)
-    local dof=#jointHandles
-    if (lowLimits and dof~=#lowLimits) or (ranges and dof~=#ranges) then
-        error("Bad table size.")
+function _S.simIKAddCallback(callback)
+    -- registers callback, and returns the reference that the plugin passes back to __simIKcb. The callback is
+    -- resolved once, here, and not for every call
+    _S.simIKCallbacks=_S.simIKCallbacks or {}
+    _S.simIKNextCallbackRef=(_S.simIKNextCallbackRef or 0)+1
+    _S.simIKCallbacks[_S.simIKNextCallbackRef]=callback
+    return _S.simIKNextCallbackRef
+end
+
+function _S.simIKCallWithCallback(callback,func)
+    -- registers callback for the duration of func(ref), so that each call has its own callback, also when calls
+    -- are nested (e.g. a callback calling the same API function)
+    local ref=_S.simIKAddCallback(callback)
+    local res=table.pack(pcall(func,ref))
+    _S.simIKCallbacks[ref]=nil
+    if not res[1] then
+        error(res[2],0)
     end
+    return table.unpack(res,2,res.n)
+end
 
-    local lb=sim.setThreadAutomaticSwitch(false)
+function __simIKcb(ref,...)
+    -- the only script function called by the plugin: dispatches to the callback registered under ref
+    return _S.simIKCallbacks[ref](...)
+end
 
-    local retVal={}
-    local ikEnv=simIK.duplicateEnvironment(ikEnvironment)
-    local x={}
-    local confS={}
-    local err=false
-    local inputConfig={}
-    for i=1,#jointHandles,1 do
-        inputConfig[i]=simIK.getJointPosition(ikEnv,jointHandles[i])
-        local c,interv=simIK.getJointInterval(ikEnv,jointHandles[i])
-        local t=simIK.getJointType(ikEnv,jointHandles[i])
-        local sp=simIK.getJointScrewLead(ikEnv,jointHandles[i])
-        if t==simIK.jointtype_revolute and not c then
-            if sp==0 then
-                if inputConfig[i]-math.pi*2>=interv[1] or inputConfig[i]+math.pi*2<=interv[1]+interv[2] then
-                    -- We use the low and range values from the joint's settings
-                    local y=inputConfig[i]
-                    while y-math.pi*2>=interv[1] do
-                        y=y-math.pi*2
-                    end
-                    x[i]={y,interv[1]+interv[2]}
-                end
-            end
-        end
-        if x[i] then
-            if lowLimits and ranges then
-                -- the user specified low and range values. Use those instead:
-                local l=lowLimits[i]
-                local r=ranges[i]
-                if r~=0 then
-                    if r>0 then
-                        if l<interv[1] then
-                            -- correct for user bad input
-                            r=r-(interv[1]-l)
-                            l=interv[1] 
-                        end
-                        if l>interv[1]+interv[2] then
-                            -- bad user input. No alternative position for this joint
-                            x[i]={inputConfig[i],inputConfig[i]}
-                            err=true
-                        else
-                            if l+r>interv[1]+interv[2] then
-                                -- correct for user bad input
-                                r=interv[1]+interv[2]-l
-                            end
-                            if inputConfig[i]-math.pi*2>=l or inputConfig[i]+math.pi*2<=l+r then
-                                local y=inputConfig[i]
-                                while y<l do
-                                    y=y+math.pi*2
-                                end
-                                while y-math.pi*2>=l do
-                                    y=y-math.pi*2
-                                end
-                                x[i]={y,l+r}
-                            else
-                                -- no alternative position for this joint
-                                x[i]={inputConfig[i],inputConfig[i]}
-                                err=(inputConfig[i]<l) or (inputConfig[i]>l+r)
-                            end
-                        end
-                    else
-                        r=-r
-                        l=inputConfig[i]-r*0.5
-                        if l<x[i][1] then
-                            l=x[i][1]
-                        end
-                        local u=inputConfig[i]+r*0.5
-                        if u>x[i][2] then
-                            u=x[i][2]
-                        end
-                        x[i]={l,u}
-                    end
-                end
-            end
-        else
-            -- there's no alternative position for this joint
-            x[i]={inputConfig[i],inputConfig[i]}
-        end
-        confS[i]=x[i][1]
+function _S.simIKForgetSimJoints(ikEnv,simJoints)
+    -- those are probably joints in a dependency relation, that were removed
+    if #simJoints==0 then
+        return
     end
-    local configs={}
-    if not err then
-        for i=1,#jointHandles,1 do
-            simIK.setJointPosition(ikEnv,jointHandles[i],inputConfig[i])
+    local envData=_S.ikEnvs[ikEnv]
+    for i=1,#simJoints,1 do
+        local k=simJoints[i]
+        local v=envData.simToIkMap[k]
+        for g,groupData in pairs(envData.ikGroups) do
+            groupData.joints[k]=nil
+        end
+        envData.simToIkMap[k]=nil
+        if v then
+            envData.ikToSimMap[v]=nil
         end
-        local desiredPose=0
-        configs=_S.simIKLoopThroughAltConfigSolutions(ikEnv,jointHandles,desiredPose,confS,x,1)
-    end
-    simIK.eraseEnvironment(ikEnv)
-    sim.setThreadAutomaticSwitch(lb)
-    
-    if next(configs)~=nil then
-        configs=Matrix:fromtable(configs)
-        configs=configs:data()
     end
-    return configs
 end
 
 function simIK.syncFromSim(...)
-    local ikEnv,ikGroups=checkargs({{type='int'},{type='table'}},...)
+    local ikEnv,ikGroups,options=checkargs({{type='int'},{type='table'},{type='table',default={}}},...)
     local lb=sim.setThreadAutomaticSwitch(false)
-    for g=1,#ikGroups,1 do
-        local groupData=_S.ikEnvs[ikEnv].ikGroups[ikGroups[g]]
-        for k,v in pairs(groupData.joints) do
-            if sim.isHandle(k) then
-                if sim.getJointType(k)==sim.joint_spherical_subtype then
-                    simIK.setSphericalJointMatrix(ikEnv,v,sim.getJointMatrix(k))
-                else
-                    simIK.setJointPosition(ikEnv,v,sim.getJointPosition(k))
-                end
-            else
-                -- that is probably a joint in a dependency relation, that was removed
-                simIK.eraseObject(ikEnv,v)
-                groupData.joints[k]=nil
-                _S.ikEnvs[ikEnv].simToIkMap[k]=nil
-                _S.ikEnvs[ikEnv].ikToSimMap[v]=nil
-            end
-        end
-        for i=1,#groupData.targetTipBaseTriplets,1 do
-            -- Make sure target relative to base is in sync too:
-            simIK.setObjectMatrix(ikEnv,groupData.targetTipBaseTriplets[i][4],groupData.targetTipBaseTriplets[i][6],sim.getObjectMatrix(groupData.targetTipBaseTriplets[i][1],groupData.targetTipBaseTriplets[i][3]))
-        end
-    end
+    local removedSimJoints=simIK._syncFromSim(ikEnv,ikGroups,options.tolerance or 0)
+    _S.simIKForgetSimJoints(ikEnv,removedSimJoints)
     sim.setThreadAutomaticSwitch(lb)
 end
 
 function simIK.syncToSim(...)
-    local ikEnv,ikGroups=checkargs({{type='int'},{type='table'}},...)
+    local ikEnv,ikGroups,options=checkargs({{type='int'},{type='table'},{type='table',default={}}},...)
     local lb=sim.setThreadAutomaticSwitch(false)
-    for g=1,#ikGroups,1 do
-        local groupData=_S.ikEnvs[ikEnv].ikGroups[ikGroups[g]]
-        for k,v in pairs(groupData.joints) do
-            if sim.isHandle(k) then
-                if sim.getJointType(k)==sim.joint_spherical_subtype then
-                    if sim.getJointMode(k)~=sim.jointmode_force or not sim.isDynamicallyEnabled(k) then
-                        sim.setSphericalJointMatrix(k,simIK.getJointMatrix(ikEnv,v))
-                    end
-                else
-                    if sim.getJointMode(k)==sim.jointmode_force and sim.isDynamicallyEnabled(k) then
-                        sim.setJointTargetPosition(k,simIK.getJointPosition(ikEnv,v))
-                    else    
-                        sim.setJointPosition(k,simIK.getJointPosition(ikEnv,v))
-                    end
-                end
-            else
-                -- that is probably a joint in a dependency relation, that was removed
-                simIK.eraseObject(ikEnv,v)
-                groupData.joints[k]=nil
-                _S.ikEnvs[ikEnv].simToIkMap[k]=nil
-                _S.ikEnvs[ikEnv].ikToSimMap[v]=nil
-            end
-        end
-    end
+    local removedSimJoints=simIK._syncToSim(ikEnv,ikGroups,options.tolerance or 0)
+    _S.simIKForgetSimJoints(ikEnv,removedSimJoints)
     sim.setThreadAutomaticSwitch(lb)
 end
 
@@ -354,6 +258,23 @@ function simIK.addElementFromScene(...)
     local ikElement=simIK.addElement(ikEnv,ikGroup,ikTip)
     simIK.setElementBase(ikEnv,ikGroup,ikElement,ikBase,-1)
     simIK.setElementConstraints(ikEnv,ikGroup,ikElement,constraints)
+
+    -- Register the scene mapping of this group with the plugin, for simIK.syncFromSim and simIK.syncToSim:
+    local simJoints={}
+    local ikJoints={}
+    for k,v in pairs(groupData.joints) do
+        simJoints[#simJoints+1]=k
+        ikJoints[#ikJoints+1]=v
+    end
+    local targets={}
+    for i=1,#groupData.targetTipBaseTriplets,1 do
+        local t=groupData.targetTipBaseTriplets[i]
+        targets[#targets+1]=t[1]
+        targets[#targets+1]=t[3]
+        targets[#targets+1]=t[4]
+        targets[#targets+1]=t[6]
+    end
+    simIK._setSyncGroup(ikEnv,ikGroup,simJoints,ikJoints,targets)
     sim.setThreadAutomaticSwitch(lb)
     return ikElement,simToIkMap,ikToSimMap
 end
@@ -371,31 +292,68 @@ function simIK.eraseEnvironment(...)
 end
 
 function simIK.findConfig(...)
-    local ikEnv,ikGroup,joints,thresholdDist,maxTime,metric,callback,auxData=checkargs({{type='int'},{type='int'},{type='table',size='1..*',item_type='int'},{type='float',default=0.1},{type='float',default=0.5},{type='table',size=4,item_type='float',default={1,1,1,0.1},nullable=true},{type='any',default=NIL,nullable=true},{type='any',default=NIL,nullable=true}},...)
+    local ikEnv,ikGroup,joints,thresholdDist,maxTime,metric,callback,auxData,options=checkargs({{type='int'},{type='int'},{type='table',size='1..*',item_type='int'},{type='float',default=0.1},{type='float',default=0.5},{type='table',size=4,item_type='float',default={1,1,1,0.1},nullable=true},{type='any',default=NIL,nullable=true},{type='any',default=NIL,nullable=true},{type='table',default={}}},...)
     local dof=#joints
     local lb=sim.setThreadAutomaticSwitch(false)
 
     --local env=simIK.duplicateEnvironment(ikEnv)
     local env=ikEnv
     if metric==nil then metric={1,1,1,0.1} end
-    function __cb(config)
-        if type(callback)=='string' then
-            return _G[callback](config,auxData)
-        else
-            return callback(config,auxData)
+    if type(callback)=='string' then
+        callback=_G[callback]
+    end
+    local function validate(config)
+        return callback(config,auxData)
+    end
+    local function validateBatch(configs)
+        -- configs is a flat table, handed over to the callback as a list of configurations, in one call. The
+        -- callback returns one boolean per configuration, handed back to the plugin as validity flags
+        local cfgs={}
+        for i=0,#configs//dof-1,1 do
+            cfgs[i+1]=table.move(configs,i*dof+1,(i+1)*dof,1,{})
+        end
+        local valid=callback(cfgs,auxData)
+        if type(valid)~='table' or #valid~=#cfgs then
+            error('the validation callback should return one boolean per configuration')
         end
+        local flags={}
+        for i=1,#cfgs,1 do
+            flags[i]=valid[i] and 1 or 0
+        end
+        return flags
+    end
+    local vTypes,vInts,vDoubles=_S.simIKPackValidators(options.validators or {})
+    local function find(ref,t)
+        return simIK._findConfig(env,ikGroup,joints,thresholdDist,maxTime*1000,metric,ref,t,options.seed,options.strategy,options.useCache,options.validationBatchSize,vTypes,vInts,vDoubles,options.simJoints,options.collisionPairs,options.starts)
     end
-    local funcNm,t
+    local retVal
     if callback then
-        funcNm='__cb'
-        t=sim.getScriptInt32Param(sim.handle_self,sim.scriptintparam_handle)
+        local t=sim.getScriptInt32Param(sim.handle_self,sim.scriptintparam_handle)
+        local cb=validate
+        if (options.validationBatchSize or 1)>1 then
+            cb=validateBatch
+        end
+        retVal=_S.simIKCallWithCallback(cb,function(ref) return find(ref,t) end)
+    else
+        retVal=find()
     end
-    local retVal=simIK._findConfig(env,ikGroup,joints,thresholdDist,maxTime*1000,metric,funcNm,t)
     --simIK.eraseEnvironment(env)
     sim.setThreadAutomaticSwitch(lb)
     return retVal
 end
 
+function simIK.getConfigSearchStats(...)
+    local reset=checkargs({{type='bool',default=false}},...)
+    local data=simIK._getConfigSearchStats(reset)
+    -- data holds 4 values per strategy, in the order of the strategy constants:
+    local retVal={}
+    for _,strategy in ipairs({simIK.sampling_random,simIK.sampling_sobol,simIK.sampling_halton,simIK.sampling_stratified}) do
+        local o=4*strategy
+        retVal[strategy]={searches=data[o+1],successes=data[o+2],samplesToSuccess=data[o+3],samples=data[o+4]}
+    end
+    return retVal
+end
+
 function simIK.handleGroup(...) -- convenience function
     local ikEnv,ikGroup,options=checkargs({{type='int'},{type='int'},{type='table',default={}}},...)
     local ikGroups={ikGroup}
@@ -544,58 +502,59 @@ function simIK.handleGroups(...)
     end
     local debugJacobian=( ((debugFlags&2)~=0) or sim.getNamedBoolParam('simIK.debug_world') ) and _S.ikEnvs[ikEnv] -- when an IK environment is duplicated, it does not appear in _S.ikEnvs...
 
-    function __cb(rows_constr,rows_ikEl,cols_handles,cols_dofIndex,jacobian,errorVect,groupId,iteration)
-        local data={}
-        data.jacobian=Matrix({data=jacobian,dims={#rows_constr,#cols_handles}})
-        data.rows={}
-        data.cols={}
-        data.e=Matrix({data=errorVect,dims={#rows_constr,1}})
-        for i=1,#rows_constr,1 do
-            data.rows[i]={constraint=rows_constr[i],element=rows_ikEl[i]}
-        end
-        for i=1,#cols_handles,1 do
-            data.cols[i]={joint=cols_handles[i],dofIndex=cols_dofIndex[i]}
+    -- row and column metadata is only sent by the plugin when it changed (nil otherwise):
+    local rows,cols={},{}
+    local callback=options.callback
+    if type(callback)=='string' then
+        callback=_G[callback] -- resolved once, not for every iteration
+    end
+    local function jacobianCallback(rows_constr,rows_ikEl,cols_handles,cols_dofIndex,jacobian,errorVect,groupId,iteration)
+        if rows_constr then
+            rows,cols={},{}
+            for i=1,#rows_constr,1 do
+                rows[i]={constraint=rows_constr[i],element=rows_ikEl[i]}
+            end
+            for i=1,#cols_handles,1 do
+                cols[i]={joint=cols_handles[i],dofIndex=cols_dofIndex[i]}
+            end
         end
+        local data={}
+        data.jacobian=Matrix({data=jacobian,dims={#rows,#cols}})
+        data.rows=rows
+        data.cols=cols
+        data.e=Matrix({data=errorVect,dims={#rows,1}})
         data.groupHandle=groupId
         data.iteration=iteration
         if debugJacobian then
             simIK.debugJacobianDisplay(data)
         end
-        local j={}
-        local e={}
-        local dq={}
-        local jpinv={}
-        if options.callback then
-            local outData
-            if type(options.callback)=='string' then
-                outData=_G[options.callback](data,options.auxData)
-            else
-                outData=options.callback(data,options.auxData)
-            end
+        local j,e,dq,jpinv -- nil means unchanged, and nothing is copied back
+        if callback then
+            local outData=callback(data,options.auxData)
             if outData then
                 if outData.jacobian then
-                    if outData.jacobian:cols()==#cols_handles and outData.jacobian:rows()==#rows_constr then
+                    if outData.jacobian:cols()==#cols and outData.jacobian:rows()==#rows then
                         j=outData.jacobian:data()
                     else
                         error("invalid jacobian matrix size")
                     end
                 end
                 if outData.e then
-                    if outData.e:rows()==#rows_constr and outData.e:cols()==1 then
+                    if outData.e:rows()==#rows and outData.e:cols()==1 then
                         e=outData.e:data()
                     else
                         error("invalid e vector size")
                     end
                 end
                 if outData.dq then
-                    if outData.dq:rows()==#cols_handles and outData.dq:cols()==1 then
+                    if outData.dq:rows()==#cols and outData.dq:cols()==1 then
                         dq=outData.dq:data()
                     else
                         error("invalid dq vector size")
                     end
                 end
                 if outData.jacobianPinv then
-                    if outData.jacobianPinv:rows()==#cols_handles and outData.jacobianPinv:cols()==#rows_constr then
+                    if outData.jacobianPinv:rows()==#cols and outData.jacobianPinv:cols()==#rows then
                         jpinv=outData.jacobianPinv:data()
                     else
                         error("invalid jacobian pseudo-inverse matrix size")
@@ -605,18 +564,19 @@ function simIK.handleGroups(...)
         end
         return j,e,dq,jpinv
     end
-    local funcNm,t
-    if options.callback or debugJacobian then
-        funcNm='__cb'
-        t=sim.getScriptInt32Param(sim.handle_self,sim.scriptintparam_handle)
-    end
     if options.syncWorlds then
-        simIK.syncFromSim(ikEnv,ikGroups)
+        simIK.syncFromSim(ikEnv,ikGroups,{tolerance=options.syncTolerance})
+    end
+    local retVal,reason,prec
+    if options.callback or debugJacobian then
+        local t=sim.getScriptInt32Param(sim.handle_self,sim.scriptintparam_handle)
+        retVal,reason,prec=_S.simIKCallWithCallback(jacobianCallback,function(ref) return simIK._handleGroups(ikEnv,ikGroups,ref,t) end)
+    else
+        retVal,reason,prec=simIK._handleGroups(ikEnv,ikGroups)
     end
-    local retVal,reason,prec=simIK._handleGroups(ikEnv,ikGroups,funcNm,t)
     if options.syncWorlds then
         if (reason&simIK.calc_notwithintolerance)==0 or options.allowError then
-            simIK.syncToSim(ikEnv,ikGroups)
+            simIK.syncToSim(ikEnv,ikGroups,{tolerance=options.syncTolerance})
         end
     end
     for i=1,#ikGroups,1 do
@@ -626,6 +586,44 @@ function simIK.handleGroups(...)
     return retVal,reason,prec
 end
 
+function simIK.handleGroupsMulti(...)
+    local entries,options=checkargs({{type='table'},{type='table',default={}}},...)
+    local lb=sim.setThreadAutomaticSwitch(false)
+    local envs={}
+    local groupCnts={}
+    local groups={}
+    local badEntries={}
+    for i=1,#entries,1 do
+        local ikGroups=entries[i][2] or {}
+        envs[i]=entries[i][1]
+        groupCnts[i]=#ikGroups
+        for j=1,#ikGroups,1 do
+            groups[#groups+1]=ikGroups[j]
+        end
+        if options.syncWorlds then
+            -- a bad entry must not prevent the others from being handled:
+            local ok,err=pcall(simIK.syncFromSim,envs[i],ikGroups,{tolerance=options.syncTolerance})
+            if not ok then
+                badEntries[i]=true
+                sim.addLog(sim.verbosity_scriptwarnings,string.format('entry %d: %s',i,err))
+            end
+        end
+    end
+    local results,reasons,prec=simIK._handleGroupsMulti(envs,groupCnts,groups)
+    local precisions={}
+    for i=1,#envs,1 do
+        precisions[i]={prec[2*i-1],prec[2*i]}
+        if badEntries[i] then results[i]=-1 end
+        if options.syncWorlds and results[i]~=-1 then
+            if (reasons[i]&simIK.calc_notwithintolerance)==0 or options.allowError then
+                simIK.syncToSim(envs[i],entries[i][2] or {},{tolerance=options.syncTolerance})
+            end
+        end
+    end
+    sim.setThreadAutomaticSwitch(lb)
+    return results,reasons,precisions
+end
+
 function simIK.getFailureDescription(reason)
     local d={}
     for _,k in ipairs{
@@ -649,76 +647,61 @@ end
 
 function simIK.setJointDependency(...)
     local ikEnv,slaveJoint,masterJoint,offset,mult,callback=checkargs({{type='int'},{type='int'},{type='int'},{type='float',default=0.0},{type='float',default=1.0},{type='any',default=NIL,nullable=true}},...)
-    function __depcb(ikEnv,slaveJoint,masterPos)
-        if type(callback)=='string' then
-            return _G[callback](ikEnv,slaveJoint,masterPos)
-        else
-            return callback(ikEnv,slaveJoint,masterPos)
+    if type(callback)=='table' then
+        -- native dependency function, evaluated without script calls:
+        local params=callback.coefficients
+        if callback.type~=simIK.dependency_polynomial then
+            params={}
+            for i=1,#callback.points,1 do
+                params[2*i-1]=callback.points[i][1]
+                params[2*i]=callback.points[i][2]
+            end
         end
+        simIK._setJointDependency(ikEnv,slaveJoint,masterJoint,offset,mult,nil,nil,callback.type,params)
+        return
     end
-    local funcNm,t
+    if type(callback)=='string' then
+        callback=_G[callback]
+    end
+    local ref,t
     if callback then
-        funcNm='__depcb'
+        -- one callback reference per environment and slave joint, kept by duplicated environments, also after
+        -- the original environment was erased. Setting the dependency again replaces the callback
+        _S.simIKJointDependRefs=_S.simIKJointDependRefs or {}
+        _S.simIKJointDependRefs[ikEnv]=_S.simIKJointDependRefs[ikEnv] or {}
+        ref=_S.simIKJointDependRefs[ikEnv][slaveJoint] or _S.simIKAddCallback()
+        _S.simIKJointDependRefs[ikEnv][slaveJoint]=ref
+        _S.simIKCallbacks[ref]=function(slaveJoint,masterPos,ikEnv)
+            return callback(ikEnv,slaveJoint,masterPos)
+        end
         t=sim.getScriptInt32Param(sim.handle_self,sim.scriptintparam_handle)
     end
-    simIK._setJointDependency(ikEnv,slaveJoint,masterJoint,offset,mult,funcNm,t)
+    simIK._setJointDependency(ikEnv,slaveJoint,masterJoint,offset,mult,ref,t)
     return retVal
 end
 
 function simIK.generatePath(...)
-    local ikEnv,ikGroup,ikJoints,tip,ptCnt,callback,auxData=checkargs({{type='int'},{type='int'},{type='table',size='1..*',item_type='int'},{type='int'},{type='int'},{type='any',default=NIL,nullable=true},{type='any',default=NIL}},...)
+    local ikEnv,ikGroup,ikJoints,tip,ptCnt,callback,auxData,options=checkargs({{type='int'},{type='int'},{type='table',size='1..*',item_type='int'},{type='int'},{type='int'},{type='any',default=NIL,nullable=true},{type='any',default=NIL},{type='table',default={}}},...)
 
     local lb=sim.setThreadAutomaticSwitch(false)
 
-    local env=simIK.duplicateEnvironment(ikEnv)
-    local targetHandle=simIK.getTargetDummy(env,tip)
-    local startMatrix=simIK.getObjectMatrix(env,tip,-1)
-    local goalMatrix=simIK.getObjectMatrix(env,targetHandle,-1)
-    local retPath={{}}
-    for i=1,#ikJoints,1 do
-        retPath[1][i]=simIK.getJointPosition(env,ikJoints[i])
+    -- interpolation and IK are handled natively on a private copy of the environment. Each point is validated as
+    -- soon as it is computed, so that the generation stops at the first invalid point
+    local vTypes,vInts,vDoubles=_S.simIKPackValidators(options.validators or {})
+    local function generate(ref,t)
+        return simIK._generatePath(ikEnv,ikGroup,ikJoints,tip,ptCnt,vTypes,vInts,vDoubles,options.simJoints,options.collisionPairs,ref,t)
     end
-    local success=true
+    local retPath
     if callback then
         if type(callback)=='string' then
-            success=_G[callback](retPath[1])
-        else
-            success=callback(retPath[1])
+            callback=_G[callback]
         end
-    end
-    if success then
-        for j=1,ptCnt-1,1 do
-            local t=j/(ptCnt-1)
-            local m=sim.interpolateMatrices(startMatrix,goalMatrix,t)
-            simIK.setObjectMatrix(env,targetHandle,-1,m)
-            success=simIK.handleGroups(env,{ikGroup})==simIK.result_success
-            if not success then
-                break
-            end
-            retPath[j+1]={}
-            for i=1,#ikJoints,1 do
-                retPath[j+1][i]=simIK.getJointPosition(env,ikJoints[i])
-            end
-            if callback then
-                if type(callback)=='string' then
-                    success=_G[callback](retPath[j+1])
-                else
-                    success=callback(retPath[j+1])
-                end
-            end
-            if not success then
-                break
-            end
-        end
-    end
-    simIK.eraseEnvironment(env)
-    sim.setThreadAutomaticSwitch(lb)
-    if not success then
-        retPath={}
+        local t=sim.getScriptInt32Param(sim.handle_self,sim.scriptintparam_handle)
+        retPath=_S.simIKCallWithCallback(function(config) return callback(config,auxData) end,function(ref) return generate(ref,t) end)
     else
-        retPath=Matrix:fromtable(retPath)
-        retPath=retPath:data()
+        retPath=generate()
     end
+    sim.setThreadAutomaticSwitch(lb)
     return retPath
 end
 
@@ -733,6 +716,22 @@ function simIK.setObjectPose(...)
     simIK.setObjectTransformation(ikEnv,obj,relObj,{pose[1],pose[2],pose[3]},{pose[4],pose[5],pose[6],pose[7]})
 end
 
+function simIK.getObjectPoses(...)
+    local ikEnv,objs,relObjs=checkargs({{type='int'},{type='table',size='1..*',item_type='int'},{type='any'}},...)
+    if type(relObjs)~='table' then
+        relObjs={relObjs}
+    end
+    return simIK._getObjectPoses(ikEnv,objs,relObjs)
+end
+
+function simIK.setObjectPoses(...)
+    local ikEnv,objs,relObjs,poses=checkargs({{type='int'},{type='table',size='1..*',item_type='int'},{type='any'},{type='table',item_type='float'}},...)
+    if type(relObjs)~='table' then
+        relObjs={relObjs}
+    end
+    simIK._setObjectPoses(ikEnv,objs,relObjs,poses)
+end
+
 function simIK.createDebugOverlay(...)
     local ikEnv,ikTip,ikBase=checkargs({{type='int'},{type='int'},{type='int',default=-1}},...)
     if not _S.ikDebug then
@@ -877,71 +876,128 @@ function simIK.solvePath(...)
     end
     local getConfig=opts.getConfig or partial(map,sim.getJointPosition,simJoints)
     local setConfig=opts.setConfig or partial(foreach,sim.setJointPosition,simJoints)
-    local getIkConfig=opts.getIkConfig or partial(map,partial(simIK.getJointPosition,ikEnv),ikJoints)
-    local setIkConfig=opts.setIkConfig or partial(foreach,partial(simIK.setJointPosition,ikEnv),ikJoints)
+    local getIkConfig=opts.getIkConfig or function() return simIK.getJointPositions(ikEnv,ikJoints) end
+    local setIkConfig=opts.setIkConfig or function(cfg) simIK.setJointPositions(ikEnv,ikJoints,cfg) end
+
+    local function getObjectAlias(h)
+        if h==sim.handle_all then return '[[all]]' end
+        local r,a=pcall(sim.getObjectAlias,h)
+        return r and a or h
+    end
+
+    local function checkCollisions(cfg,posAlongPath)
+        if #collisionPairs==0 then return true end
+        local origSimCfg=getConfig()
+        setConfig(cfg)
+        for i=1,#collisionPairs,2 do
+            if sim.checkCollision(collisionPairs[i],collisionPairs[i+1])~=0 then
+                reportError('Failed due to collision %s/%s at t=%.2f',getObjectAlias(collisionPairs[i]),getObjectAlias(collisionPairs[i+1]),posAlongPath/totalLength)
+                setConfig(origSimCfg)
+                return false
+            end
+        end
+        setConfig(origSimCfg)
+        return true
+    end
 
     -- save current robot config:
-    local origIkCfg=getIkConfig()
-
-    local cfgs={}
-    local posAlongPath=0
-    local finished=false
-
-    -- find initial config:
-    moveIkTarget(0)
-    local cfg=simIK.findConfig(ikEnv,ikGroup,ikJoints)
-    if not cfg then
-        reportError('Failed to find initial config')
-        goto fail
+    local origIkCfg,origIkState
+    if opts.getIkConfig or opts.setIkConfig then
+        origIkCfg=getIkConfig()
+    else
+        origIkState=simIK.saveState(ikEnv,ikJoints)
     end
+    local function restoreIkConfig()
+        if origIkState then
+            simIK.restoreState(ikEnv,origIkState)
+            simIK.eraseState(origIkState)
+        else
+            setIkConfig(origIkCfg)
+        end
+    end
+
+    -- the saved state is restored and released also if a callback raises an error:
+    local function solve()
+        local cfgs={}
+        local cfgPositions={} -- position along the path of each config
+        local posAlongPath=0
+        local finished=false
 
-    -- apply config in ik world:
-    setIkConfig(cfg)
-
-    -- follow path via IK solver:
-    while not finished do
-        if math.abs(posAlongPath-totalLength)<1e-6 then finished=true end
-        -- move target to next position:
-        moveIkTarget(posAlongPath)
-        -- if IK failed, return failure:
-        local ikResult,failureCode=simIK.handleGroups(ikEnv,{ikGroup},{callback=opts.jacobianCallback})
-        if ikResult~=simIK.result_success then
-            reportError('Failed to perform IK step at t=%.2f (reason: %s)',posAlongPath/totalLength,simIK.getFailureDescription(failureCode))
+        -- find initial config:
+        moveIkTarget(0)
+        local cfg=simIK.findConfig(ikEnv,ikGroup,ikJoints)
+        if not cfg then
+            reportError('Failed to find initial config')
             goto fail
         end
-        -- if collidableHandle given, and there is a collision, return failure:
-        if #collisionPairs>0 then
-            local origSimCfg=getConfig()
-            setConfig(getIkConfig())
-            for i=1,#collisionPairs,2 do
-                if sim.checkCollision(collisionPairs[i],collisionPairs[i+1])~=0 then
-                    local function getObjectAlias(h)
-                        if h==sim.handle_all then return '[[all]]' end
-                        local r,a=pcall(sim.getObjectAlias,h)
-                        return r and a or h
-                    end
-                    reportError('Failed due to collision %s/%s at t=%.2f',getObjectAlias(collisionPairs[i]),getObjectAlias(collisionPairs[i+1]),posAlongPath/totalLength)
-                    setConfig(origSimCfg)
+
+        -- apply config in ik world:
+        setIkConfig(cfg)
+
+        if not (opts.moveIkTarget or opts.getIkConfig or opts.setIkConfig or opts.jacobianCallback or opts.stepCallback) then
+            -- follow path natively. Fixed steps of delta by default. Adaptive steps are opt-in: opts.minDelta enables
+            -- bisection when IK fails, opts.maxDelta lets steps grow, and opts.maxJointStep detects joint jumps:
+            local params={delta,opts.minDelta or delta,opts.maxDelta or delta,opts.maxJointStep or 0}
+            -- collisions are checked natively, unless the scene config is accessed via custom functions:
+            local nativeCollisions=not (opts.getConfig or opts.setConfig)
+            local configs,positions,failure,failureCode,failPos
+            if nativeCollisions then
+                configs,positions,failure,failureCode,failPos=simIK._solvePath(ikEnv,ikGroup,ikTarget,ikJoints,ikPath,pathData,params,simJoints,collisionPairs)
+            else
+                configs,positions,failure,failureCode,failPos=simIK._solvePath(ikEnv,ikGroup,ikTarget,ikJoints,ikPath,pathData,params)
+            end
+            local dof=#ikJoints
+            for i=1,#positions do
+                cfg=table.move(configs,(i-1)*dof+1,i*dof,1,{})
+                if not nativeCollisions and not checkCollisions(cfg,positions[i]) then goto fail end
+                table.insert(cfgs,cfg)
+                table.insert(cfgPositions,positions[i])
+            end
+            if failure==3 then
+                reportError('Failed due to collision %s/%s at t=%.2f',getObjectAlias(collisionPairs[2*failureCode+1]),getObjectAlias(collisionPairs[2*failureCode+2]),failPos/totalLength)
+                goto fail
+            elseif failure==1 then
+                reportError('Failed to perform IK step at t=%.2f (reason: %s)',failPos/totalLength,simIK.getFailureDescription(failureCode))
+                goto fail
+            elseif failure==2 then
+                reportError('Failed due to a joint jump at t=%.2f',failPos/totalLength)
+                goto fail
+            end
+        else
+            -- follow path via IK solver:
+            while not finished do
+                if math.abs(posAlongPath-totalLength)<1e-6 then finished=true end
+                -- move target to next position:
+                moveIkTarget(posAlongPath)
+                -- if IK failed, return failure:
+                local ikResult,failureCode=simIK.handleGroups(ikEnv,{ikGroup},{callback=opts.jacobianCallback})
+                if ikResult~=simIK.result_success then
+                    reportError('Failed to perform IK step at t=%.2f (reason: %s)',posAlongPath/totalLength,simIK.getFailureDescription(failureCode))
                     goto fail
                 end
+                cfg=getIkConfig()
+                -- if collidableHandle given, and there is a collision, return failure:
+                if not checkCollisions(cfg,posAlongPath) then goto fail end
+                callStepCb(false)
+                -- otherwise store config and continue:
+                table.insert(cfgs,cfg)
+                table.insert(cfgPositions,posAlongPath)
+                -- move position on path forward:
+                posAlongPath=math.min(posAlongPath+delta,totalLength)
             end
-            setConfig(origSimCfg)
         end
-        callStepCb(false)
-        -- otherwise store config and continue:
-        table.insert(cfgs,getIkConfig())
-        -- move position on path forward:
-        posAlongPath=math.min(posAlongPath+delta,totalLength)
-    end
 
-    if cfgs then
-        setIkConfig(origIkCfg)
-        return cfgs
-    end
+        if cfgs then
+            return cfgs,cfgPositions
+        end
 
-    ::fail::
-    callStepCb(true)
-    setIkConfig(origIkCfg)
+        ::fail::
+        callStepCb(true)
+    end
+    local ok,cfgs,cfgPositions=pcall(solve)
+    restoreIkConfig()
+    if not ok then error(cfgs,0) end
+    return cfgs,cfgPositions
 end
 
 function simIK.addIkElementFromScene(...)
@@ -986,7 +1042,8 @@ function simIK.getConfigForTipPose(...)
 
     local lb=sim.setThreadAutomaticSwitch(false)
 
-    local env=simIK.duplicateEnvironment(ikEnv)
+    -- the search works on a pooled copy of the environment, maintained by the plugin:
+    local env=ikEnv
     if metric==nil then metric={1,1,1,0.1} end
     if jointOptions==nil then jointOptions={} end
     if lowLimits==nil then lowLimits={} end
@@ -994,42 +1051,44 @@ function simIK.getConfigForTipPose(...)
     local retVal
     if type(callback)=='string' then
         -- deprecated
-        retVal=simIK._getConfigForTipPose(env,ikGroup,joints,thresholdDist,maxTime,metric,callback,auxData,jointOptions,lowLimits,ranges)
+        retVal=simIK._getConfigForTipPose(env,ikGroup,joints,thresholdDist,maxTime,metric,callback,auxData,jointOptions,lowLimits,ranges,true)
     else
         if maxTime<0 then 
             maxTime=-maxTime/1000 -- probably calling the function the old way 
         end
         if maxTime>2 then maxTime=2 end
-        function __cb(config)
-            return callback(config,auxData)
+        local function getConfig(ref,t)
+            return simIK._getConfigForTipPose(env,ikGroup,joints,thresholdDist,-maxTime*1000,metric,nil,t,jointOptions,lowLimits,ranges,true,ref)
         end
-        local funcNm,t
         if callback then
-            funcNm='__cb'
-            t=sim.getScriptInt32Param(sim.handle_self,sim.scriptintparam_handle)
+            local t=sim.getScriptInt32Param(sim.handle_self,sim.scriptintparam_handle)
+            retVal=_S.simIKCallWithCallback(function(config) return callback(config,auxData) end,function(ref) return getConfig(ref,t) end)
+        else
+            retVal=getConfig()
         end
-        retVal=simIK._getConfigForTipPose(env,ikGroup,joints,thresholdDist,-maxTime*1000,metric,funcNm,t,jointOptions,lowLimits,ranges)
     end
-    simIK.eraseEnvironment(env)
     sim.setThreadAutomaticSwitch(lb)
     return retVal
 end
 
 function simIK.init()
     -- can only be executed once sim.* functions were initialized
-    sim.registerScriptFunction('simIK.getAlternateConfigs@simIK','float[] configs=simIK.getAlternateConfigs(int environmentHandle,int[] jointHandles,float[] lowLimits=nil,float[] ranges=nil)')
     sim.registerScriptFunction('simIK.addElementFromScene@simIK','int ikElement,map simToIkMap,map ikToSimMap=simIK.addElementFromScene(int environmentHandle,int ikGroup,int baseHandle,int tipHandle,int targetHandle,int constraints)')
-    sim.registerScriptFunction('simIK.syncFromSim@simIK','simIK.syncFromSim(int environmentHandle,int[] ikGroups)')
-    sim.registerScriptFunction('simIK.syncToSim@simIK','simIK.syncToSim(int environmentHandle,int[] ikGroups)')
+    sim.registerScriptFunction('simIK.syncFromSim@simIK','simIK.syncFromSim(int environmentHandle,int[] ikGroups,map options={})')
+    sim.registerScriptFunction('simIK.syncToSim@simIK','simIK.syncToSim(int environmentHandle,int[] ikGroups,map options={})')
     sim.registerScriptFunction('simIK.handleGroup@simIK','int success,int flags,float[2] precision=simIK.handleGroup(int environmentHandle,int ikGroup,map options={})')
     sim.registerScriptFunction('simIK.handleGroups@simIK','int success,int flags,float[2] precision=simIK.handleGroups(int environmentHandle,int[] ikGroups,map options={})')
+    sim.registerScriptFunction('simIK.handleGroupsMulti@simIK','int[] results,int[] flags,table precisions=simIK.handleGroupsMulti(table entries,map options={})')
     sim.registerScriptFunction('simIK.eraseEnvironment@simIK','simIK.eraseEnvironment(int environmentHandle)')
-    sim.registerScriptFunction('simIK.findConfig@simIK','float[] jointPositions=simIK.findConfig(int environmentHandle,int ikGroupHandle,int[] jointHandles,float thresholdDist=0.1,float maxTime=0.5,float[4] metric={1,1,1,0.1},func validationCallback=nil,any auxData=nil)')
+    sim.registerScriptFunction('simIK.findConfig@simIK','float[] jointPositions=simIK.findConfig(int environmentHandle,int ikGroupHandle,int[] jointHandles,float thresholdDist=0.1,float maxTime=0.5,float[4] metric={1,1,1,0.1},func validationCallback=nil,any auxData=nil,map options={})')
+    sim.registerScriptFunction('simIK.getConfigSearchStats@simIK','map stats=simIK.getConfigSearchStats(bool reset=false)')
     sim.registerScriptFunction('simIK.getFailureDescription@simIK','string description=simIK.getFailureDescription(int reason)')
-    sim.registerScriptFunction('simIK.setJointDependency@simIK','simIK.setJointDependency(int environmentHandle,int jointHandle,int masterJointHandle,float offset=0.0,float mult=1.0,func callback=nil)')
-    sim.registerScriptFunction('simIK.generatePath@simIK','float[] path=simIK.generatePath(int environmentHandle,int ikGroupHandle,int[] jointHandles,int tipHandle,int pathPointCount,func validationCallback=nil,any auxData=nil)')
+    sim.registerScriptFunction('simIK.setJointDependency@simIK','simIK.setJointDependency(int environmentHandle,int jointHandle,int masterJointHandle,float offset=0.0,float mult=1.0,any callback=nil)')
+    sim.registerScriptFunction('simIK.generatePath@simIK','float[] path=simIK.generatePath(int environmentHandle,int ikGroupHandle,int[] jointHandles,int tipHandle,int pathPointCount,func validationCallback=nil,any auxData=nil,map options={})')
     sim.registerScriptFunction('simIK.getObjectPose@simIK','float[7] pose=simIK.getObjectPose(int environmentHandle,int objectHandle,int relativeToObjectHandle)')
     sim.registerScriptFunction('simIK.setObjectPose@simIK','simIK.setObjectPose(int environmentHandle,int objectHandle,int relativeToObjectHandle,float[7] pose)')
+    sim.registerScriptFunction('simIK.getObjectPoses@simIK','float[] poses=simIK.getObjectPoses(int environmentHandle,int[] objectHandles,any relativeToObjectHandles)')
+    sim.registerScriptFunction('simIK.setObjectPoses@simIK','simIK.setObjectPoses(int environmentHandle,int[] objectHandles,any relativeToObjectHandles,float[] poses)')
     sim.registerScriptFunction('simIK.createDebugOverlay@simIK','int debugObject=simIK.createDebugOverlay(int environmentHandle,int tipHandle,int baseHandle=-1)')
     sim.registerScriptFunction('simIK.eraseDebugOverlay@simIK','simIK.eraseDebugOverlay(int debugObject)')
     simIK.init=nil
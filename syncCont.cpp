@@ -0,0 +1,67 @@
+#include "syncCont.h"
+#include <stddef.h>
+
+CSyncCont::CSyncCont()
+{
+}
+
+CSyncCont::~CSyncCont()
+{
+}
+
+void CSyncCont::setGroup(int env,int group,const SSyncGroup& groupData)
+{
+    _groups[env][group]=groupData;
+}
+
+SSyncGroup* CSyncCont::getGroup(int env,int group)
+{
+    SSyncGroup* retVal=nullptr;
+    auto it=_groups.find(env);
+    if (it!=_groups.end())
+    {
+        auto it2=it->second.find(group);
+        if (it2!=it->second.end())
+            retVal=&it2->second;
+    }
+    return(retVal);
+}
+
+void CSyncCont::removeJoint(int env,int simJoint)
+{ // a joint can be shared by several groups of the same environment
+    auto it=_groups.find(env);
+    if (it!=_groups.end())
+    {
+        for (auto& group : it->second)
+        {
+            std::vector<SSyncJoint>& joints=group.second.joints;
+            for (size_t i=0;i<joints.size();i++)
+            {
+                if (joints[i].simJoint==simJoint)
+                {
+                    joints.erase(joints.begin()+i);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void CSyncCont::invalidateTargets(int env)
+{ // IK objects of env were moved or restructured: the next sync from the scene has to compare all targets again
+    auto it=_groups.find(env);
+    if (it!=_groups.end())
+    {
+        for (auto& group : it->second)
+        {
+            std::vector<SSyncTarget>& targets=group.second.targets;
+            for (size_t i=0;i<targets.size();i++)
+                targets[i].syncedMatrixValid=false;
+        }
+    }
+}
+
+void CSyncCont::removeEnv(int env)
+{
+    _groups.erase(env);
+}
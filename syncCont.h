@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+#include <map>
+
+struct SSyncJoint
+{
+    int simJoint;
+    int ikJoint;
+    bool spherical;
+};
+
+struct SSyncTarget
+{
+    int simTarget;
+    int simBase;
+    int ikTarget;
+    int ikBase;
+    double syncedMatrix[12]; // scene pose of the target relative to its base, at the last sync from the scene
+    bool syncedMatrixValid; // reset when the IK side could have moved the target
+};
+
+struct SSyncGroup
+{
+    std::vector<SSyncJoint> joints;
+    std::vector<SSyncTarget> targets;
+};
+
+class CSyncCont
+{ // scene <--> IK environment mappings, as built by simIK.addElementFromScene. Access only with the interface locked
+public:
+    CSyncCont();
+    virtual ~CSyncCont();
+
+    void setGroup(int env,int group,const SSyncGroup& groupData);
+    SSyncGroup* getGroup(int env,int group);
+    void removeJoint(int env,int simJoint);
+    void invalidateTargets(int env);
+    void removeEnv(int env);
+
+private:
+    std::map<int,std::map<int,SSyncGroup>> _groups; // env --> (group --> mapping)
+};